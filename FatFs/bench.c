@@ -0,0 +1,113 @@
+#include <stdint.h>
+#include <stdio.h>
+#include "source/pal.h"
+#include "source/ff.h"
+#include "source/diskio.h"
+
+// ======================================================================
+// FatFs benchmark
+// Build it in place of main.c by switching SRCS in the Makefile. With
+// -DDISK_STATS every line also gives the sectors read and written.
+// ======================================================================
+#define SEC_SIZE    512
+#define BENCH_FILE  "bench.bin"
+#define BENCH_SIZE  (640 * 480 * 2 + 54)   // one RGB565 slide
+#define BENCH_RUNS  4
+#define BENCH_FILL  16      // slide-sized files written and freed before the rewrite runs
+
+static CLINTRegBlk *const clint = (CLINTRegBlk *)CLINT_BASE;
+
+static FATFS   fs;
+static FIL     fil;
+static uint8_t buf[SEC_SIZE];
+
+// Read the 64-bit machine timer without tearing between halves
+static uint64_t bench_ticks(void) {
+    uint32_t hi, lo;
+    do {
+        hi = clint->mtime.h;
+        lo = clint->mtime.l;
+    } while (hi != clint->mtime.h);
+    return ((uint64_t)hi << 32) | lo;
+}
+
+// Sectors moved since the previous call, empty without DISK_STATS
+static void bench_sectors(void) {
+#ifdef DISK_STATS
+    static DWORD reads, writes;
+
+    printf(", %lu sectors read, %lu written", (unsigned long)(disk_reads - reads), (unsigned long)(disk_writes - writes));
+    reads = disk_reads;
+    writes = disk_writes;
+#endif
+    printf("\n");
+}
+
+// Sustained write: one slide-sized file, sector-sized f_write calls, closed at the end.
+// FA_CREATE_ALWAYS frees the previous chain first, so later runs are rewrites.
+static uint32_t bench_write(const char *name) {
+    UINT bw;
+    uint64_t t0 = bench_ticks();
+
+    if (f_open(&fil, name, FA_CREATE_ALWAYS | FA_WRITE)) return 0;
+    for (uint32_t done = 0; done < BENCH_SIZE; done += bw) {
+        uint32_t n = BENCH_SIZE - done;
+        if (n > SEC_SIZE) n = SEC_SIZE;
+        if (f_write(&fil, buf, n, &bw) || bw != n) {
+            f_close(&fil);
+            return 0;
+        }
+    }
+    f_close(&fil);
+
+    return (uint32_t)(bench_ticks() - t0);
+}
+
+int main(void) {
+    for (uint32_t i = 0; i < SEC_SIZE; i++) buf[i] = (uint8_t)i;
+
+    if (f_mount(&fs, "", 1)) {
+        printf("f_mount failed\n");
+        while (1);
+    }
+
+#if FF_USE_AUALLOC
+    f_setvolalloc("", AP_AU);   // every bench file starts on a free allocation unit
+#endif
+    printf("=== FatFs bench (FF_FS_LAZYMIRROR=%d, FF_USE_AUALLOC=%d, FF_USE_TRIM=%d, n_fats=%d) ===\n",
+           FF_FS_LAZYMIRROR, FF_USE_AUALLOC, FF_USE_TRIM, fs.n_fats);
+    for (int run = 0; run < BENCH_RUNS; run++) {
+        uint32_t ticks = bench_write(BENCH_FILE);
+        printf("write %d bytes: %lu ticks", BENCH_SIZE, (unsigned long)ticks);
+        bench_sectors();
+    }
+
+    // Age the card: fill, then free, so the rewrites below land on used flash.
+    // With FF_USE_TRIM the unlink erases each freed run, which shows up in its time.
+    char name[16];
+    for (int i = 0; i < BENCH_FILL; i++) {
+        snprintf(name, sizeof(name), "fill%d.bin", i);
+        if (!bench_write(name)) break;
+    }
+    printf("fill %d files", BENCH_FILL);
+    bench_sectors();
+    uint64_t t0 = bench_ticks();
+    for (int i = 0; i < BENCH_FILL; i++) {
+        snprintf(name, sizeof(name), "fill%d.bin", i);
+        f_unlink(name);
+    }
+    printf("free %d files: %lu ticks", BENCH_FILL, (unsigned long)(bench_ticks() - t0));
+    bench_sectors();
+    for (int run = 0; run < BENCH_RUNS; run++) {
+        uint32_t ticks = bench_write(BENCH_FILE);
+        printf("rewrite %d bytes: %lu ticks", BENCH_SIZE, (unsigned long)ticks);
+        bench_sectors();
+    }
+
+    f_unlink(BENCH_FILE);
+    f_mount(0, "", 0);
+    printf("=== bench done ===\n");
+
+    while (1) { /* spin */ }
+    return 0;
+}
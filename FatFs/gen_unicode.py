@@ -0,0 +1,260 @@
+# gen_unicode.py
+# Emits a trimmed ffunicode.c holding only what ffconf.h selects:
+#   - the OEM tables and conversion functions of FF_CODE_PAGE
+#   - ff_wtoupper() on a sorted range table with a binary search
+# and prints how many .rodata bytes that saves against the stock module.
+#
+# usage: python3 FatFs/gen_unicode.py [-o out.c] [--report] [--conf ffconf.h]
+import os, re, sys, argparse
+
+SRC_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), "source")
+FFCONF = os.path.join(SRC_DIR, "ffconf.h")
+FFUNICODE = os.path.join(SRC_DIR, "ffunicode.c")
+
+# Range entry: start, info = pairs flag (delta on odd offsets only) | delta index | length
+RANGE_PAIRS = 0x8000
+ENTRY_BYTES = 4
+
+
+def conf_value(text, name):
+    m = re.search(r"^#define\s+%s\s+(\d+)" % name, text, re.M)
+    if not m:
+        sys.exit("%s not found in ffconf.h" % name)
+    return int(m.group(1))
+
+
+def array_words(text, name):
+    m = re.search(r"static const (?:WCHAR|WORD) %s\[\] = \{(.*?)\};" % name, text, re.S)
+    if not m:
+        sys.exit("table %s not found in ffunicode.c" % name)
+    body = re.sub(r"/\*.*?\*/", "", m.group(1), flags=re.S)
+    return [int(v, 16) for v in re.findall(r"0x[0-9A-Fa-f]+", body)], m.group(0)
+
+
+def section(text, start, end):
+    # Lines from the one starting with start up to (not including) the one starting with end
+    i = text.index(start)
+    j = text.index(end, i + len(start))
+    return text[i:j]
+
+
+# ----------------------------------------------------------------------
+# Up-case mapping, decoded from the stock compressed tables so both
+# modules give the same answer for every BMP code point
+# ----------------------------------------------------------------------
+def stock_upcase(cvt1, cvt2):
+    up = list(range(0x10000))
+    shift = {2: -16, 3: -32, 4: -48, 5: -26, 6: 8, 7: -80, 8: -0x1C60}
+    for c in range(0x10000):
+        p = cvt1 if c < 0x1000 else cvt2
+        i = 0
+        while True:
+            bc = p[i]; i += 1
+            if bc == 0 or c < bc:
+                break
+            nc = p[i]; i += 1
+            cmd, nc = nc >> 8, nc & 0xFF
+            if c < bc + nc:
+                if cmd == 0:
+                    up[c] = p[i + c - bc]
+                elif cmd == 1:
+                    up[c] = c - ((c - bc) & 1)
+                else:
+                    up[c] = c + shift[cmd]
+                break
+            if cmd == 0:
+                i += nc
+    return up
+
+
+def build_ranges(up):
+    ranges = []
+    c = 0
+    while c < 0x10000:
+        if up[c] == c:
+            c += 1
+            continue
+        # Case pairs: upper at even offset, lower maps to the one before
+        if up[c] == c - 1 and c > 0 and up[c - 1] == c - 1:
+            n = 1
+            while c + n + 1 < 0x10000 and up[c + n] == c + n and up[c + n + 1] == c + n:
+                n += 2
+            if n >= 3:
+                ranges.append((c - 1, n + 1, -1, True))
+                c += n
+                continue
+        d = up[c] - c
+        n = 1
+        while c + n < 0x10000 and up[c + n] - (c + n) == d:
+            n += 1
+        ranges.append((c, n, d, False))
+        c += n
+    return ranges
+
+
+def range_upcase(ranges, c):
+    # Same search as the emitted C
+    li, hi = 0, len(ranges)
+    while hi - li > 1:
+        i = (li + hi) // 2
+        if c >= ranges[i][0]:
+            li = i
+        else:
+            hi = i
+    s, n, d, pairs = ranges[li]
+    if s <= c < s + n and (not pairs or (c - s) & 1):
+        return c + d
+    return c
+
+
+# ----------------------------------------------------------------------
+# Emitters
+# ----------------------------------------------------------------------
+def range_deltas(ranges):
+    return sorted(set(d for _, _, d, _ in ranges))
+
+
+def emit_ranges(ranges):
+    deltas = range_deltas(ranges)
+    if len(deltas) > 0x7F or max(n for _, n, _, _ in ranges) > 0xFF:
+        sys.exit("up-case ranges do not fit the 16-bit info field")
+    lines = []
+    for s, n, d, pairs in ranges:
+        info = (RANGE_PAIRS if pairs else 0) | deltas.index(d) << 8 | n
+        lines.append("\t0x%04X,0x%04X," % (s, info))
+    return "\n".join(lines)
+
+
+def emit_deltas(ranges):
+    deltas = [str(d) for d in range_deltas(ranges)]
+    return "\n".join("\t" + ",".join(deltas[i:i + 16]) + "," for i in range(0, len(deltas), 16))
+
+
+WTOUPPER = """
+/*------------------------------------------------------------------------*/
+/* Unicode Up-case Conversion                                             */
+/*------------------------------------------------------------------------*/
+
+/* uc_range[] holds {start, info} pairs sorted by start, info is:
+/  bit15     UC_PAIRS, the delta applies to odd offsets only (case pairs)
+/  bit14-8   index into uc_delta[]
+/  bit7-0    number of code points in the range
+*/
+
+#define UC_PAIRS	0x8000
+
+static const short uc_delta[] = {	/* Up-case offsets */
+%(deltas)s
+};
+
+static const WORD uc_range[] = {	/* Range table for U+0000 - U+FFFF */
+%(ranges)s
+};
+
+DWORD ff_wtoupper (	/* Returns up-converted code point */
+	DWORD uni		/* Unicode code point to be up-converted */
+)
+{
+	UINT li, hi, i;
+	WORD uc, ofs, info;
+
+
+	if (uni < 0x10000) {	/* Is it in BMP? */
+		uc = (WORD)uni;
+		li = 0; hi = sizeof uc_range / sizeof uc_range[0] / 2;
+		while (hi - li > 1) {	/* Find the last range starting at or below uc */
+			i = (li + hi) / 2;
+			if (uc >= uc_range[i * 2]) {
+				li = i;
+			} else {
+				hi = i;
+			}
+		}
+		ofs = uc - uc_range[li * 2];
+		info = uc_range[li * 2 + 1];
+		if (uc >= uc_range[li * 2] && ofs < (info & 0xFF) && (!(info & UC_PAIRS) || (ofs & 1))) {
+			uni = (WORD)(uc + uc_delta[(info >> 8) & 0x7F]);
+		}
+	}
+
+	return uni;
+}
+"""
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("-o", dest="out", help="generated module (default: stdout)")
+    ap.add_argument("--report", action="store_true", help="print the .rodata size report")
+    ap.add_argument("--conf", default=FFCONF, help="ffconf.h to follow")
+    args = ap.parse_args()
+
+    conf = open(args.conf).read()
+    src = open(FFUNICODE).read()
+    cp = conf_value(conf, "FF_CODE_PAGE")
+    lfn = conf_value(conf, "FF_USE_LFN")
+    if cp == 0:
+        sys.exit("FF_CODE_PAGE 0 needs every table, build the stock ffunicode.c")
+
+    # Tables the stock module compiles in for this configuration
+    if cp >= 900:
+        cp_tables = ["uni2oem%d" % cp, "oem2uni%d" % cp]
+        conv = section(src, "#if FF_CODE_PAGE >= 900\nWCHAR ff_uni2oem", "/*---", )
+    else:
+        cp_tables = ["uc%d" % cp]
+        conv = section(src, "#if FF_CODE_PAGE != 0 && FF_CODE_PAGE < 900\nWCHAR ff_uni2oem", "/*---")
+    cp_text = []
+    cp_bytes = 0
+    for name in cp_tables:
+        words, text = array_words(src, name)
+        cp_text.append(text)
+        cp_bytes += 2 * len(words)
+
+    cvt1, _ = array_words(src, "cvt1")
+    cvt2, _ = array_words(src, "cvt2")
+    up = stock_upcase(cvt1, cvt2)
+    ranges = build_ranges(up)
+    for c in range(0x10000):
+        if range_upcase(ranges, c) != up[c]:
+            sys.exit("range table mismatch at U+%04X" % c)
+
+    head = src[:src.index("#if FF_USE_LFN != 0")]
+    out = []
+    out.append("/* Generated by FatFs/gen_unicode.py for FF_CODE_PAGE %d, do not edit. */\n" % cp)
+    out.append(head)
+    out.append("#if FF_CODE_PAGE != %d\n#error Regenerate this module, FF_CODE_PAGE has changed\n#endif\n\n" % cp)
+    out.append("#if FF_USE_LFN != 0\t/* This module will be blanked if in non-LFN configuration */\n\n")
+    out.append("#define MERGE2(a, b) a ## b\n#define CVTBL(tbl, cp) MERGE2(tbl, cp)\n\n")
+    out.append("\n/*------------------------------------------------------------------------*/\n")
+    out.append("/* Code Conversion Tables                                                 */\n")
+    out.append("/*------------------------------------------------------------------------*/\n\n")
+    out.append("\n".join(cp_text) + "\n\n\n")
+    out.append(conv.rstrip() + "\n\n\n")
+    out.append(WTOUPPER % {"ranges": emit_ranges(ranges), "deltas": emit_deltas(ranges)})
+    out.append("\n#endif /* #if FF_USE_LFN != 0 */\n")
+    text = "".join(out)
+
+    if args.out:
+        open(args.out, "w").write(text)
+    else:
+        sys.stdout.write(text)
+
+    if args.report:
+        stock_up = 2 * (len(cvt1) + len(cvt2))
+        gen_up = ENTRY_BYTES * len(ranges) + 2 * len(range_deltas(ranges))
+        stock = cp_bytes + stock_up if lfn else 0
+        gen = cp_bytes + gen_up if lfn else 0
+        rep = sys.stderr if not args.out else sys.stdout
+        rep.write("ffunicode .rodata for FF_CODE_PAGE %d, FF_USE_LFN %d\n" % (cp, lfn))
+        rep.write("  code page tables  %6d bytes (%s)\n" % (cp_bytes, ", ".join(cp_tables)))
+        rep.write("  up-case, stock    %6d bytes (linear scan of cvt1/cvt2)\n" % stock_up)
+        rep.write("  up-case, ranges   %6d bytes (%d ranges, binary search)\n" % (gen_up, len(ranges)))
+        rep.write("  linked, stock     %6d bytes\n" % stock)
+        rep.write("  linked, generated %6d bytes\n" % gen)
+        rep.write("  reclaimed         %6d bytes\n" % (stock - gen))
+        if not lfn:
+            rep.write("  (FF_USE_LFN 0: both modules compile empty, SFN up-casing uses ExCvt in ff.c)\n")
+
+
+if __name__ == "__main__":
+    main()
@@ -14,6 +14,11 @@
 /* Definitions of physical drive number for each drive */
 #define DEV_SD		0	/* Example: Map SD card to physical drive 0 */
 
+#ifdef DISK_STATS
+DWORD disk_reads;
+DWORD disk_writes;
+#endif
+
 
 /*-----------------------------------------------------------------------*/
 /* Get Drive Status                                                      */
@@ -86,6 +91,9 @@ DRESULT disk_read (
 		// translate the arguments here
 
 		result = SD_disk_read(buff, sector, count);
+#ifdef DISK_STATS
+		disk_reads += count;
+#endif
 		if(result == 0) res = RES_OK;
 		else res = RES_ERROR;
 		// translate the result code here
@@ -120,6 +128,9 @@ DRESULT disk_write (
 		DSTATUS sd_state = disk_status(0);
 		if(sd_state) return RES_NOTRDY;
 		result = SD_disk_write((unsigned char*) buff, sector, count);
+#ifdef DISK_STATS
+		disk_writes += count;
+#endif
 		if(!result) res = RES_OK;
 		else res = RES_ERROR;
 		// translate the result code here
@@ -164,10 +175,19 @@ DRESULT disk_ioctl (
 			return RES_OK;
 		}
 		else if(cmd == GET_BLOCK_SIZE) {
+			// Allocation unit of the card, read once since it does not change
+			static DWORD au_size = 0;
 			DWORD* new_buff = (DWORD*) buff;
-			*new_buff = 1;
+			if(au_size == 0) au_size = SD_disk_au_size();
+			*new_buff = au_size ? au_size : 1;
 			return RES_OK;
 		}
+		else if(cmd == CTRL_TRIM) {
+			// Freed cluster run {start, end}, erased so the card stops carrying it as live data
+			LBA_t* range = (LBA_t*) buff;
+			result = SD_disk_erase(range[0], range[1]);
+			return result ? RES_ERROR : RES_OK;
+		}
 		return res;
 	}
 
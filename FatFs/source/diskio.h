@@ -32,6 +32,11 @@ DRESULT disk_read (BYTE pdrv, BYTE* buff, LBA_t sector, UINT count);
 DRESULT disk_write (BYTE pdrv, const BYTE* buff, LBA_t sector, UINT count);
 DRESULT disk_ioctl (BYTE pdrv, BYTE cmd, void* buff);
 
+#ifdef DISK_STATS
+extern DWORD disk_reads;	/* Number of sectors read since power-up */
+extern DWORD disk_writes;	/* Number of sectors written since power-up */
+#endif
+
 
 /* Disk Status Bits (DSTATUS) */
 
@@ -43,6 +43,7 @@
 #define MAX_FAT16	0xFFF5			/* Max FAT16 clusters (differs from specs, but right for real DOS/Windows behavior) */
 #define MAX_FAT32	0x0FFFFFF5		/* Max FAT32 clusters (not defined in specs, practical limit) */
 #define MAX_EXFAT	0x7FFFFFFD		/* Max exFAT clusters (differs from specs, implementation limit) */
+#define MAX_AUSCAN	32				/* Max allocation units to be tested to find a wholly free one */
 
 
 /* Character code support macros */
@@ -293,6 +294,22 @@ typedef struct {	/* Open object identifier with status */
 #endif
 
 
+/* Cluster allocation for the file data */
+#if !FF_FS_READONLY && FF_USE_AUALLOC
+#define CREATE_FCHAIN(fp, clst)	create_chain_au(fp, clst)	/* Apply the allocation policy of the file */
+#else
+#define CREATE_FCHAIN(fp, clst)	create_chain(&(fp)->obj, clst)
+#endif
+
+
+/* Deferred 2nd FAT update */
+#if FF_FS_LAZYMIRROR
+#if FF_LAZYMIRROR_MAP < 1 || FF_LAZYMIRROR_MAP > 255
+#error Wrong FF_LAZYMIRROR_MAP setting
+#endif
+#endif
+
+
 /* SBCS up-case tables (\x80-\xFF) */
 #define TBL_CT437  {0x80,0x9A,0x45,0x41,0x8E,0x41,0x8F,0x80,0x45,0x45,0x45,0x49,0x49,0x49,0x8E,0x8F, \
 					0x90,0x92,0x92,0x4F,0x99,0x4F,0x55,0x55,0x59,0x99,0x9A,0x9B,0x9C,0x9D,0x9E,0x9F, \
@@ -1067,7 +1084,16 @@ static FRESULT sync_window (	/* Returns FR_OK or FR_DISK_ERR */
 		if (disk_write(fs->pdrv, fs->win, fs->winsect, 1) == RES_OK) {	/* Write it back into the volume */
 			fs->wflag = 0;	/* Clear window dirty flag */
 			if (fs->winsect - fs->fatbase < fs->fsize) {	/* Is it in the 1st FAT? */
+#if FF_FS_LAZYMIRROR
+				if (fs->n_fats == 2) {	/* Defer reflecting it to 2nd FAT until next sync */
+					DWORD i = (DWORD)(fs->winsect - fs->fatbase) / fs->mir_unit;
+
+					fs->mir_map[i / 8] |= 1 << (i % 8);
+					fs->mir_flag = 1;
+				}
+#else
 				if (fs->n_fats == 2) disk_write(fs->pdrv, fs->win, fs->winsect + fs->fsize, 1);	/* Reflect it to 2nd FAT if needed */
+#endif
 			}
 		} else {
 			res = FR_DISK_ERR;
@@ -1078,6 +1104,37 @@ static FRESULT sync_window (	/* Returns FR_OK or FR_DISK_ERR */
 #endif
 
 
+#if !FF_FS_READONLY && FF_FS_LAZYMIRROR
+static FRESULT sync_mirror (	/* Returns FR_OK or FR_DISK_ERR */
+	FATFS* fs			/* Filesystem object */
+)
+{
+	FRESULT res;
+	DWORD i, n;
+	LBA_t sect;
+
+
+	res = sync_window(fs);	/* Flush the window (it may mark the last FAT sector) */
+	if (res != FR_OK || !fs->mir_flag) return res;
+
+	for (i = 0; i < FF_LAZYMIRROR_MAP * 8; i++) {	/* Reflect each dirty part of 1st FAT to 2nd FAT */
+		if (!(fs->mir_map[i / 8] & (1 << (i % 8)))) continue;
+		sect = fs->fatbase + i * fs->mir_unit;
+		for (n = fs->mir_unit; n && sect - fs->fatbase < fs->fsize; n--, sect++) {
+			if (sect != fs->winsect && disk_read(fs->pdrv, fs->win, fs->winsect = sect, 1) != RES_OK) {
+				fs->winsect = (LBA_t)0 - 1;	/* Invalidate window */
+				return FR_DISK_ERR;
+			}
+			if (disk_write(fs->pdrv, fs->win, sect + fs->fsize, 1) != RES_OK) return FR_DISK_ERR;
+		}
+		fs->mir_map[i / 8] &= ~(1 << (i % 8));
+	}
+	fs->mir_flag = 0;	/* 2nd FAT is up to date */
+	return FR_OK;
+}
+#endif
+
+
 static FRESULT move_window (	/* Returns FR_OK or FR_DISK_ERR */
 	FATFS* fs,		/* Filesystem object */
 	LBA_t sect		/* Sector LBA to make appearance in the fs->win[] */
@@ -1116,7 +1173,11 @@ static FRESULT sync_fs (	/* Returns FR_OK or FR_DISK_ERR */
 	FRESULT res;
 
 
+#if FF_FS_LAZYMIRROR
+	res = sync_mirror(fs);		/* Flush the window and bring 2nd FAT up to date */
+#else
 	res = sync_window(fs);
+#endif
 	if (res == FR_OK) {
 		if (fs->fsi_flag == 1) {	/* Allocation changed? */
 			fs->fsi_flag = 0;
@@ -1633,6 +1694,98 @@ static DWORD create_chain (	/* 0:No free cluster, 1:Internal error, 0xFFFFFFFF:D
 	return ncl;		/* Return new cluster number or error status */
 }
 
+
+
+#if FF_USE_AUALLOC
+/*-----------------------------------------------------------------------*/
+/* FAT handling - Find a wholly free allocation unit                     */
+/*-----------------------------------------------------------------------*/
+
+static DWORD find_free_au (	/* 0:Not found, 1:Internal error, 0xFFFFFFFF:Disk error, >=2:Top cluster of the AU */
+	FFOBJID* obj,		/* Corresponding object */
+	DWORD clst			/* Cluster to start to find after its AU */
+)
+{
+	DWORD n_au, au, n, scl, ncl, cs;
+	FATFS *fs = obj->fs;
+
+
+	n_au = (fs->n_fatent - 2 + fs->au_ofs) / fs->au_clst;	/* Number of AUs with the top cluster in the volume */
+	au = (clst >= 2 && clst < fs->n_fatent) ? (clst - 2 + fs->au_ofs) / fs->au_clst + 1 : 0;
+	for (n = 0; n < n_au && n < MAX_AUSCAN; n++, au++) {
+		if (au >= n_au) au = 0;			/* Wrap-around */
+		if (au == 0 && fs->au_ofs != 0) continue;	/* Skip partial AU at top of the data area */
+		scl = au * fs->au_clst + 2 - fs->au_ofs;
+		if (scl + fs->au_clst > fs->n_fatent) continue;	/* Skip partial AU at end of the data area */
+		for (ncl = scl; ncl < scl + fs->au_clst; ncl++) {	/* Test if all clusters in the AU are free */
+			cs = get_fat(obj, ncl);
+			if (cs == 1 || cs == 0xFFFFFFFF) return cs;
+			if (cs != 0) break;
+		}
+		if (ncl == scl + fs->au_clst) return scl;
+	}
+	return 0;
+}
+
+
+
+
+/*-----------------------------------------------------------------------*/
+/* FAT handling - Stretch a file chain under its allocation policy       */
+/*-----------------------------------------------------------------------*/
+
+static DWORD create_chain_au (	/* 0:No free cluster, 1:Internal error, 0xFFFFFFFF:Disk error, >=2:New cluster# */
+	FIL* fp,			/* File object */
+	DWORD clst			/* Cluster# to stretch, 0:Create a new chain */
+)
+{
+	DWORD cs, ncl;
+	FRESULT res;
+	FATFS *fs = fp->obj.fs;
+
+
+	if (fp->alloc != AP_AU || fs->au_clst == 0 || fs->fs_type == FS_EXFAT) {	/* Next-fit policy or AU unknown? */
+		return create_chain(&fp->obj, clst);
+	}
+
+	ncl = 0;
+	if (clst != 0) {	/* Stretch a chain */
+		cs = get_fat(&fp->obj, clst);		/* Check the cluster status */
+		if (cs < 2) return 1;				/* Test for insanity */
+		if (cs == 0xFFFFFFFF) return cs;	/* Test for disk error */
+		if (cs < fs->n_fatent) return cs;	/* It is already followed by next cluster */
+		if (fs->free_clst == 0) return 0;	/* No free cluster */
+		for (ncl = clst + 1; ncl < fs->n_fatent && (ncl - 2 + fs->au_ofs) % fs->au_clst != 0; ncl++) {	/* Find a free cluster in rest of the AU */
+			cs = get_fat(&fp->obj, ncl);
+			if (cs == 1 || cs == 0xFFFFFFFF) return cs;
+			if (cs == 0) break;
+		}
+		if (ncl >= fs->n_fatent || (ncl - 2 + fs->au_ofs) % fs->au_clst == 0) ncl = 0;	/* The AU is full */
+	}
+	if (ncl == 0) {		/* Move on to a wholly free AU */
+		ncl = find_free_au(&fp->obj, clst ? clst : fs->last_clst);
+		if (ncl == 1 || ncl == 0xFFFFFFFF) return ncl;
+		if (ncl == 0) return create_chain(&fp->obj, clst);	/* No free AU is found in the range, fall back to next-fit */
+	}
+
+	res = put_fat(fs, ncl, 0xFFFFFFFF);		/* Mark the new cluster 'EOC' */
+	if (res == FR_OK && clst != 0) {
+		res = put_fat(fs, clst, ncl);		/* Link it from the previous one if needed */
+	}
+	if (res == FR_OK) {			/* Update allocation information if the function succeeded */
+		fs->last_clst = ncl;
+		if (fs->free_clst > 0 && fs->free_clst <= fs->n_fatent - 2) {
+			fs->free_clst--;
+			fs->fsi_flag |= 1;
+		}
+	} else {
+		ncl = (res == FR_DISK_ERR) ? 0xFFFFFFFF : 1;	/* Failed. Generate error status */
+	}
+
+	return ncl;		/* Return new cluster number or error status */
+}
+#endif	/* FF_USE_AUALLOC */
+
 #endif /* !FF_FS_READONLY */
 
 
@@ -3602,6 +3755,22 @@ static FRESULT mount_volume (	/* FR_OK(0): successful, !=0: an error occurred */
 #endif	/* !FF_FS_READONLY */
 	}
 
+#if !FF_FS_READONLY && FF_USE_AUALLOC
+	{	/* Get allocation unit geometry in unit of cluster */
+		DWORD au_sect;
+
+		fs->au_clst = fs->au_ofs = 0;	/* AU aware allocation is not available by default */
+		if (disk_ioctl(fs->pdrv, GET_BLOCK_SIZE, &au_sect) == RES_OK && au_sect > fs->csize && au_sect % fs->csize == 0) {
+			fs->au_clst = au_sect / fs->csize;
+			fs->au_ofs = (DWORD)(fs->database % au_sect) / fs->csize;
+		}
+	}
+#endif
+#if !FF_FS_READONLY && FF_FS_LAZYMIRROR
+	fs->mir_unit = (fs->fsize + FF_LAZYMIRROR_MAP * 8 - 1) / (FF_LAZYMIRROR_MAP * 8);	/* FAT sectors per dirty map bit */
+	fs->mir_flag = 0;		/* 2nd FAT is in sync at mount time */
+	memset(fs->mir_map, 0, sizeof fs->mir_map);
+#endif
 	fs->fs_type = (BYTE)fmt;/* FAT sub-type (the filesystem object gets valid) */
 	fs->id = ++Fsid;		/* Volume mount ID */
 #if FF_USE_LFN == 1
@@ -3688,6 +3857,9 @@ FRESULT f_mount (
 	cfs = FatFs[vol];			/* Pointer to the filesystem object of the volume */
 
 	if (cfs) {					/* Unregister current filesystem object if registered */
+#if !FF_FS_READONLY && FF_FS_LAZYMIRROR
+		if (cfs->fs_type && cfs->mir_flag) sync_mirror(cfs);	/* Bring 2nd FAT up to date before it is forgotten */
+#endif
 		FatFs[vol] = 0;
 #if FF_FS_LOCK
 		clear_share(cfs);
@@ -3714,6 +3886,9 @@ FRESULT f_mount (
 #endif
 #endif
 		fs->fs_type = 0;		/* Invalidate the new filesystem object */
+#if !FF_FS_READONLY && FF_USE_AUALLOC
+		fs->au_pol = AP_NEXT;	/* Default allocation policy */
+#endif
 		FatFs[vol] = fs;		/* Register new fs object */
 	}
 
@@ -3877,6 +4052,9 @@ FRESULT f_open (
 			fp->obj.fs = fs;	/* Validate the file object */
 			fp->obj.id = fs->id;
 			fp->flag = mode;	/* Set file access mode */
+#if !FF_FS_READONLY && FF_USE_AUALLOC
+			fp->alloc = fs->au_pol;	/* Inherit allocation policy of the volume */
+#endif
 			fp->err = 0;		/* Clear error flag */
 			fp->sect = 0;		/* Invalidate current data sector */
 			fp->fptr = 0;		/* Set file pointer top of the file */
@@ -4059,7 +4237,7 @@ FRESULT f_write (
 				if (fp->fptr == 0) {		/* On the top of the file? */
 					clst = fp->obj.sclust;	/* Follow from the origin */
 					if (clst == 0) {		/* If no cluster is allocated, */
-						clst = create_chain(&fp->obj, 0);	/* create a new cluster chain */
+						clst = CREATE_FCHAIN(fp, 0);	/* create a new cluster chain */
 					}
 				} else {					/* On the middle or end of the file */
 #if FF_USE_FASTSEEK
@@ -4068,7 +4246,7 @@ FRESULT f_write (
 					} else
 #endif
 					{
-						clst = create_chain(&fp->obj, fp->clust);	/* Follow or stretch cluster chain on the FAT */
+						clst = CREATE_FCHAIN(fp, fp->clust);	/* Follow or stretch cluster chain on the FAT */
 					}
 				}
 				if (clst == 0) break;		/* Could not allocate a new cluster (disk full) */
@@ -4544,7 +4722,7 @@ FRESULT f_lseek (
 				clst = fp->obj.sclust;					/* start from the first cluster */
 #if !FF_FS_READONLY
 				if (clst == 0) {						/* If no cluster chain, create a new chain */
-					clst = create_chain(&fp->obj, 0);
+					clst = CREATE_FCHAIN(fp, 0);
 					if (clst == 1) ABORT(fs, FR_INT_ERR);
 					if (clst == 0xFFFFFFFF) ABORT(fs, FR_DISK_ERR);
 					fp->obj.sclust = clst;
@@ -4561,7 +4739,7 @@ FRESULT f_lseek (
 							fp->obj.objsize = fp->fptr;
 							fp->flag |= FA_MODIFIED;
 						}
-						clst = create_chain(&fp->obj, clst);	/* Follow chain with forceed stretch */
+						clst = CREATE_FCHAIN(fp, clst);	/* Follow chain with forceed stretch */
 						if (clst == 0) {				/* Clip file size in case of disk full */
 							ofs = 0; break;
 						}
@@ -5576,6 +5754,54 @@ FRESULT f_setlabel (
 
 
 
+#if FF_USE_AUALLOC && !FF_FS_READONLY
+/*-----------------------------------------------------------------------*/
+/* Set Cluster Allocation Policy of a File                               */
+/*-----------------------------------------------------------------------*/
+
+FRESULT f_setalloc (
+	FIL* fp,		/* Pointer to the file object */
+	BYTE pol		/* Allocation policy (AP_NEXT or AP_AU) */
+)
+{
+	FRESULT res;
+	FATFS *fs;
+
+
+	res = validate(&fp->obj, &fs);		/* Check validity of the file object */
+	if (res == FR_OK && pol > AP_AU) res = FR_INVALID_PARAMETER;
+	if (res == FR_OK) fp->alloc = pol;
+
+	LEAVE_FF(fs, res);
+}
+
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Set Default Cluster Allocation Policy of a Volume                     */
+/*-----------------------------------------------------------------------*/
+
+FRESULT f_setvolalloc (
+	const TCHAR* path,	/* Logical drive number */
+	BYTE pol			/* Allocation policy to be inherited by the files opened after this */
+)
+{
+	FRESULT res;
+	FATFS *fs;
+
+
+	res = mount_volume(&path, &fs, 0);	/* Get logical drive */
+	if (res == FR_OK && pol > AP_AU) res = FR_INVALID_PARAMETER;
+	if (res == FR_OK) fs->au_pol = pol;
+
+	LEAVE_FF(fs, res);
+}
+
+#endif /* FF_USE_AUALLOC && !FF_FS_READONLY */
+
+
+
 #if FF_USE_EXPAND && !FF_FS_READONLY
 /*-----------------------------------------------------------------------*/
 /* Allocate a Contiguous Blocks to the File                              */
@@ -5743,6 +5969,114 @@ FRESULT f_forward (
 
 
 
+#if FF_USE_STREAM
+/*-----------------------------------------------------------------------*/
+/* Stream File Data to the Sink in Place                                 */
+/*-----------------------------------------------------------------------*/
+
+FRESULT f_stream (
+	FIL* fp, 						/* Pointer to the file object */
+	UINT (*func)(const BYTE*,UINT),	/* Pointer to the sink function (returns number of bytes consumed) */
+	BYTE* sbuf,						/* Burst buffer for multi-sector reads (null:every sector goes through the sector cache) */
+	UINT nsect,						/* Size of the burst buffer [sectors] */
+	UINT btf,						/* Number of bytes to stream */
+	UINT* bf						/* Pointer to number of bytes consumed by the sink */
+)
+{
+	FRESULT res;
+	FATFS *fs;
+	DWORD clst;
+	LBA_t sect;
+	FSIZE_t remain;
+	UINT rcnt, scnt, cc, csect;
+	BYTE *dbuf;
+
+
+	*bf = 0;	/* Clear transfer byte counter */
+	res = validate(&fp->obj, &fs);		/* Check validity of the file object */
+	if (res != FR_OK || (res = (FRESULT)fp->err) != FR_OK) LEAVE_FF(fs, res);
+	if (!(fp->flag & FA_READ)) LEAVE_FF(fs, FR_DENIED);	/* Check access mode */
+
+	remain = fp->obj.objsize - fp->fptr;
+	if (btf > remain) btf = (UINT)remain;			/* Truncate btf by remaining bytes */
+
+	for ( ; btf > 0; fp->fptr += scnt, *bf += scnt, btf -= scnt) {	/* Repeat until all data consumed or the sink stops */
+		csect = (UINT)(fp->fptr / SS(fs) & (fs->csize - 1));	/* Sector offset in the cluster */
+		if (fp->fptr % SS(fs) == 0 && csect == 0) {	/* On the cluster boundary? */
+			clst = (fp->fptr == 0) ?			/* On the top of the file? */
+				fp->obj.sclust : get_fat(&fp->obj, fp->clust);
+			if (clst <= 1) ABORT(fs, FR_INT_ERR);
+			if (clst == 0xFFFFFFFF) ABORT(fs, FR_DISK_ERR);
+			fp->clust = clst;					/* Update current cluster */
+		}
+		sect = clst2sect(fs, fp->clust);		/* Get current data sector */
+		if (sect == 0) ABORT(fs, FR_INT_ERR);
+		sect += csect;
+		cc = (fp->fptr % SS(fs) == 0 && sbuf) ? btf / SS(fs) : 0;	/* Whole sectors to be read in a burst */
+		if (cc > nsect) cc = nsect;
+		if (csect + cc > fs->csize) cc = fs->csize - csect;	/* Clip at cluster boundary */
+		if (cc > 1) {							/* Read contiguous sectors directly into the burst buffer */
+			if (disk_read(fs->pdrv, sbuf, sect, cc) != RES_OK) ABORT(fs, FR_DISK_ERR);
+#if !FF_FS_READONLY		/* Replace one of the read sectors with cached data if it contains a dirty sector */
+#if FF_FS_TINY
+			if (fs->wflag && fs->winsect - sect < cc) {
+				memcpy(sbuf + ((fs->winsect - sect) * SS(fs)), fs->win, SS(fs));
+			}
+#else
+			if ((fp->flag & FA_DIRTY) && fp->sect - sect < cc) {
+				memcpy(sbuf + ((fp->sect - sect) * SS(fs)), fp->buf, SS(fs));
+			}
+#endif
+#endif
+			dbuf = sbuf;
+			rcnt = SS(fs) * cc;
+		} else {								/* Go through the sector cache */
+#if FF_FS_TINY
+			if (move_window(fs, sect) != FR_OK) ABORT(fs, FR_DISK_ERR);	/* Move sector window to the file data */
+			dbuf = fs->win;
+#else
+			if (fp->sect != sect) {		/* Fill sector cache with file data */
+#if !FF_FS_READONLY
+				if (fp->flag & FA_DIRTY) {		/* Write-back dirty sector cache */
+					if (disk_write(fs->pdrv, fp->buf, fp->sect, 1) != RES_OK) ABORT(fs, FR_DISK_ERR);
+					fp->flag &= (BYTE)~FA_DIRTY;
+				}
+#endif
+				if (disk_read(fs->pdrv, fp->buf, sect, 1) != RES_OK) ABORT(fs, FR_DISK_ERR);
+			}
+			dbuf = fp->buf;
+#endif
+			fp->sect = sect;
+			dbuf += (UINT)fp->fptr % SS(fs);
+			rcnt = SS(fs) - (UINT)fp->fptr % SS(fs);	/* Number of bytes remains in the sector */
+		}
+		if (rcnt > btf) rcnt = btf;					/* Clip it by btf if needed */
+		scnt = (*func)(dbuf, rcnt);					/* Hand the data to the sink */
+		if (scnt > rcnt) ABORT(fs, FR_INT_ERR);
+		if (scnt < rcnt) {							/* The sink has stopped */
+			fp->fptr += scnt; *bf += scnt;
+			if (dbuf == sbuf && fp->fptr % SS(fs) != 0) {	/* Stopped in middle of a burst sector? */
+#if !FF_FS_TINY
+#if !FF_FS_READONLY
+				if (fp->flag & FA_DIRTY) {		/* Write-back dirty sector cache */
+					if (disk_write(fs->pdrv, fp->buf, fp->sect, 1) != RES_OK) ABORT(fs, FR_DISK_ERR);
+					fp->flag &= (BYTE)~FA_DIRTY;
+				}
+#endif
+				memcpy(fp->buf, sbuf + scnt / SS(fs) * SS(fs), SS(fs));	/* Keep the sector in the cache for following reads */
+#endif
+				fp->sect = sect + scnt / SS(fs);
+			}
+			break;
+		}
+	}
+
+	LEAVE_FF(fs, FR_OK);
+}
+#endif /* FF_USE_STREAM */
+
+
+
 #if !FF_FS_READONLY && FF_USE_MKFS
 /*-----------------------------------------------------------------------*/
 /* Create FAT/exFAT volume (with sub-functions)                          */
@@ -169,6 +169,16 @@ typedef struct {
 	LBA_t	database;		/* Data base sector */
 #if FF_FS_EXFAT
 	LBA_t	bitbase;		/* Allocation bitmap base sector */
+#endif
+#if !FF_FS_READONLY && FF_USE_AUALLOC
+	DWORD	au_clst;		/* Clusters per allocation unit (0:AU aware allocation is not available) */
+	DWORD	au_ofs;			/* Offset of the first cluster in its allocation unit [clusters] */
+	BYTE	au_pol;			/* Default allocation policy of the files opened on the volume */
+#endif
+#if !FF_FS_READONLY && FF_FS_LAZYMIRROR
+	DWORD	mir_unit;		/* Number of FAT sectors covered by a bit in mir_map[] */
+	BYTE	mir_flag;		/* 2nd FAT status (1:out of date) */
+	BYTE	mir_map[FF_LAZYMIRROR_MAP];	/* Dirty map of FAT sectors not yet reflected to the 2nd FAT */
 #endif
 	LBA_t	winsect;		/* Current sector appearing in the win[] */
 	BYTE	win[FF_MAX_SS];	/* Disk access window for Directory, FAT (and file data at tiny cfg) */
@@ -212,6 +222,9 @@ typedef struct {
 	LBA_t	dir_sect;		/* Sector number containing the directory entry (not used at exFAT) */
 	BYTE*	dir_ptr;		/* Pointer to the directory entry in the win[] (not used at exFAT) */
 #endif
+#if !FF_FS_READONLY && FF_USE_AUALLOC
+	BYTE	alloc;			/* Cluster allocation policy (AP_NEXT or AP_AU) */
+#endif
 #if FF_USE_FASTSEEK
 	DWORD*	cltbl;			/* Pointer to the cluster link map table (nulled on open, set by application) */
 #endif
@@ -327,7 +340,10 @@ FRESULT f_getfree (const TCHAR* path, DWORD* nclst, FATFS** fatfs);	/* Get numbe
 FRESULT f_getlabel (const TCHAR* path, TCHAR* label, DWORD* vsn);	/* Get volume label */
 FRESULT f_setlabel (const TCHAR* label);							/* Set volume label */
 FRESULT f_forward (FIL* fp, UINT(*func)(const BYTE*,UINT), UINT btf, UINT* bf);	/* Forward data to the stream */
+FRESULT f_stream (FIL* fp, UINT(*func)(const BYTE*,UINT), BYTE* sbuf, UINT nsect, UINT btf, UINT* bf);	/* Hand file data to the sink sector by sector */
 FRESULT f_expand (FIL* fp, FSIZE_t fsz, BYTE opt);					/* Allocate a contiguous block to the file */
+FRESULT f_setalloc (FIL* fp, BYTE pol);								/* Set cluster allocation policy of the file */
+FRESULT f_setvolalloc (const TCHAR* path, BYTE pol);				/* Set default cluster allocation policy of the volume */
 FRESULT f_mount (FATFS* fs, const TCHAR* path, BYTE opt);			/* Mount/Unmount a logical drive */
 FRESULT f_mkfs (const TCHAR* path, const MKFS_PARM* opt, void* work, UINT len);	/* Create a FAT volume */
 FRESULT f_fdisk (BYTE pdrv, const LBA_t ptbl[], void* work);		/* Divide a physical drive into some partitions */
@@ -402,6 +418,10 @@ void ff_mutex_give (int vol);		/* Unlock sync object */
 /* Fast seek controls (2nd argument of f_lseek function) */
 #define CREATE_LINKMAP	((FSIZE_t)0 - 1)
 
+/* Cluster allocation policies (2nd argument of f_setalloc/f_setvolalloc function) */
+#define AP_NEXT		0x00	/* Next free cluster after the last allocated one */
+#define AP_AU		0x01	/* Start at a wholly free allocation unit and fill it before moving on */
+
 /* Format options (2nd argument of f_mkfs function) */
 #define FM_FAT		0x01
 #define FM_FAT32	0x02
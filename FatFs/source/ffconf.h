@@ -42,6 +42,15 @@
 /* This option switches f_expand(). (0:Disable or 1:Enable) */
 
 
+#define FF_USE_AUALLOC	0
+/* This option switches the allocation unit aware cluster allocation policy and
+/  f_setalloc()/f_setvolalloc(). (0:Disable or 1:Enable) When a file is set to
+/  AP_AU, its new chain starts at the top of a wholly free allocation unit (AU,
+/  the erase block of the card) and the chain is kept in the AU until it fills.
+/  The AU size is obtained with GET_BLOCK_SIZE command of disk_ioctl() at mount
+/  time, and the policy falls back to AP_NEXT if it is not available. */
+
+
 #define FF_USE_CHMOD	0
 /* This option switches attribute control API functions, f_chmod() and f_utime().
 /  (0:Disable or 1:Enable) Also FF_FS_READONLY needs to be 0 to enable this option. */
@@ -56,6 +65,12 @@
 /* This option switches f_forward(). (0:Disable or 1:Enable) */
 
 
+#define FF_USE_STREAM	1
+/* This option switches f_stream(), a sector-granular read that hands the file
+/  data to a sink function in place instead of copying it to a user buffer.
+/  (0:Disable or 1:Enable) */
+
+
 #define FF_USE_STRFUNC	1
 #define FF_PRINT_LLI	0
 #define FF_PRINT_FLOAT	0
@@ -213,7 +228,7 @@
 /  f_fdisk(). 2^32 sectors maximum. This option has no effect when FF_LBA64 == 0. */
 
 
-#define FF_USE_TRIM		0
+#define FF_USE_TRIM		1
 /* This option switches support for ATA-TRIM. (0:Disable or 1:Enable)
 /  To enable this feature, also CTRL_TRIM command should be implemented to
 /  the disk_ioctl(). */
@@ -263,6 +278,27 @@
 */
 
 
+#define FF_FS_LAZYMIRROR	0
+#define FF_LAZYMIRROR_MAP	64
+/* The option FF_FS_LAZYMIRROR switches deferred update of the 2nd FAT. When it
+/  is enabled and the volume has two FATs, a dirty FAT sector flushed from the
+/  window is written to the 1st FAT only and marked in a dirty map. The 2nd FAT
+/  is brought up to date in a single pass at f_sync(), f_close() and unmount.
+/  The 1st FAT is always authoritative and FatFs never reads the 2nd FAT, so a
+/  power loss between syncs leaves the 2nd FAT as a consistent copy of the state
+/  at the last sync point. Disk checkers report it as a FAT mismatch and repair
+/  it from the 1st FAT.
+/
+/   0: Write both FATs on every FAT sector flush.
+/   1: Defer the 2nd FAT update to the next sync.
+/
+/  FF_LAZYMIRROR_MAP defines the size of the dirty map in bytes (1-255). Each bit
+/  covers an equal share of the FAT sectors, so a larger map makes the mirror
+/  pass copy fewer clean sectors. On a 32GB FAT32 card with 32KB clusters a
+/  64 byte map copies 17 sectors per dirty bit, more than the 2nd FAT writes
+/  it defers, so it is off by default. */
+
+
 #define FF_FS_LOCK		0
 /* The option FF_FS_LOCK switches file lock function to control duplicated file open
 /  and illegal operation to open objects. This option must be 0 when FF_FS_READONLY
@@ -32,6 +32,7 @@
 #define DMA_BASE            ((uint32_t)0x90001000)
 #define UART_BASE           ((uint32_t)0x90002000)
 #define PLIC_BASE           ((uint32_t)0xA0000000)
+#define VGA_BASE            ((uint32_t)0xD0000000)
 
 // IO Mux alternate pin functions
 #define IOM_F0_UART_TX  (1<<0)
@@ -112,6 +113,61 @@
 #define TIM_TCCMR_PWM2     (7<<5)
 #define TIM_TCCMR_IRQ_EN   (1<<8)
 
+// VGA constants
+// Apertures and register block (offsets from VGA_BASE)
+#define VGA_PIXEL_OFFSET  0x000000    // one RGB565 pixel per word
+#define VGA_PACKED_OFFSET 0x200000    // two RGB565 pixels per word
+#define VGA_REG_OFFSET    0x400000
+#define VGA_LUT_OFFSET    0x400400    // output LUTs, one 8-bit level per word, write-only
+#define VGA_HOFS_OFFSET   0x400800    // one signed line offset per screen line, write-only
+#define VGA_TXT_PAL_OFFSET 0x401000   // 16 RGB565 text overlay colours, write-only
+#define VGA_TXT_OFFSET    0x402000    // text overlay cells, one per word, write-only
+#define VGA_STREAM_OFFSET 0x600000    // next two pixels of the stream window, any address
+#define VGA_PAGES         3           // 640x480 pages in the SRAM
+// Board-specific: the PLIC source the SoC top wires the vga_ahb irq line to.
+// 5 is a placeholder, not taken from aftx07.sv; build with -DVGA_IRQ=n to match
+// the board. A wrong value only loses the vblank hook, every wait polls.
+#ifndef VGA_IRQ
+#define VGA_IRQ           5
+#endif
+// Front page register fields
+#define VGA_FRONT_PAGE    (0x3<<0)
+#define VGA_FRONT_PENDING (1<<8)      // flip requested, waits for the next frame
+// Position (BLT_SRC, BLT_DST, STRM_POS) and size (BLT_SIZE, STRM_SIZE) fields
+#define VGA_XY(page, x, y) (((uint32_t)(page)<<28) | ((uint32_t)(y)<<16) | (uint32_t)(x))
+#define VGA_WH(w, h)       (((uint32_t)(h)<<16) | (uint32_t)(w))
+// Blitter control register fields
+#define VGA_BLT_ROP_COPY  (0<<0)      // D = S
+#define VGA_BLT_ROP_AND   (1<<0)      // D = S & D
+#define VGA_BLT_ROP_OR    (2<<0)      // D = S | D
+#define VGA_BLT_ROP_XOR   (3<<0)      // D = S ^ D
+#define VGA_BLT_SRC_MEM   (1<<2)      // S read at BLT_SRC, else BLT_COLOR
+#define VGA_BLT_IRQ_EN    (1<<8)
+#define VGA_BLT_START     (1<<31)
+// Blitter status register fields
+#define VGA_BLT_BUSY      (1<<0)
+#define VGA_BLT_DONE      (1<<1)      // write 1 to clear
+// Stream control register fields, writing it rewinds the stream
+#define VGA_STRM_FLIP     (1<<0)      // rows go upwards (BMP order)
+#define VGA_STRM_SKIP     (1<<1)      // drop the low half of the first word
+#define VGA_STRM_FULL     (1<<8)
+// Vblank control register fields
+#define VGA_VBL_PENDING   (1<<0)      // vblank started, write 1 to clear
+#define VGA_VBL_IRQ_EN    (1<<8)
+
+#define VGA_SCALE_MAX     3           // 8x, scale holds the log2
+// Output LUTs, word index from VGA_LUT_OFFSET of field value 0
+#define VGA_LUT_R         0           // 32 entries
+#define VGA_LUT_G         64          // 64 entries
+#define VGA_LUT_B         128         // 32 entries
+#define VGA_BRIGHT_MAX    256         // gain 1.0
+// Text overlay: 8x8 glyphs drawn 2x over the whole screen
+#define VGA_TXT_COLS      40
+#define VGA_TXT_ROWS      30
+#define VGA_TXT_EN        (1<<0)
+#define VGA_TXT_KEY       0xF81F      // reset key, palette entry 0 holds it (transparent)
+#define VGA_TXT_CELL(ch, fg, bg) (((uint32_t)(bg)<<12) | ((uint32_t)(fg)<<8) | ((uint32_t)(ch) & 0x7F))
+
 // DMA constants
 // Control register fields
 #define DMA_CR_EN      (1<<0)
@@ -300,6 +356,30 @@ typedef struct {
 #define PLIC_CLAIM_COMPLETE(base, context_num) \
     (__IO uint32_t *)((uint32_t)(base) + 0x200004 + 0x1000*(context_num))
 
+// VGA register block (VGA_BASE + VGA_REG_OFFSET)
+typedef struct {
+    __IO uint32_t front;  // page scanned out, changes at the start of a frame
+    __IO uint32_t wpage;  // page the apertures write
+    __IO uint32_t view_pos;   // VGA_XY() of the image on screen, taken at the next flip
+    __IO uint32_t view_size;  // VGA_WH() of the image, stored top-left in the page
+    __IO uint32_t blt_src;
+    __IO uint32_t blt_dst;
+    __IO uint32_t blt_size;
+    __IO uint32_t blt_color;
+    __IO uint32_t blt_ctrl;
+    __IO uint32_t blt_status;
+    __IO uint32_t strm_pos;
+    __IO uint32_t strm_size;
+    __IO uint32_t strm_ctrl;
+    __I  uint32_t frame;  // frames started since reset, counts at vblank start
+    __IO uint32_t vbl_ctrl;
+    __IO uint32_t scale;  // log2 of the zoom, taken at the next flip
+    __IO uint32_t scroll; // VGA_XY() of the image pixel at the view's top-left, taken every frame
+    __IO uint32_t bright; // output gain after the LUTs, VGA_BRIGHT_MAX = 1.0
+    __IO uint32_t txt_ctrl; // VGA_TXT_EN
+    __IO uint32_t txt_key;  // RGB565 overlay colour shown as transparent
+} VGARegBlk;
+
 // DMA register block
 typedef struct {
     uint32_t reserved;
@@ -94,7 +94,13 @@ int sd_read_block(unsigned char* buffer, uint32_t sector_no) {
 		printf("Attempted reading of SD card at block %d, command 17 gave no response\n", sector_no);
 		return -1;
 	}
-	
+	return sd_read_data(buffer, 512);
+}
+
+int sd_read_data(unsigned char* buffer, int len) {
+	// Receives one data block after its command has been accepted, CS is low on entry
+	volatile unsigned int* GPIO_0_DATA = (unsigned int*) 0x80000000;
+
 	// Reading Data Token
 	int attempts = 0;
 	const int MAX_ATTEMPTS = 512*8;
@@ -117,12 +123,13 @@ int sd_read_block(unsigned char* buffer, uint32_t sector_no) {
 		attempts++;
 	}
 	if(attempts == MAX_ATTEMPTS) {
+		*GPIO_0_DATA |= Pin3; // set CS High
 		printf("Timed out waiting for data token\n");
 		return -1;
 	};
 
 	// Reading in data values
-	for (int cur_byte = 0; cur_byte < 512; cur_byte++) {
+	for (int cur_byte = 0; cur_byte < len; cur_byte++) {
 		buffer[cur_byte] = sd_rcv_byte();
 	}
 
@@ -184,3 +191,62 @@ int SD_disk_write(unsigned char* buffer, uint32_t sector_no, unsigned int count)
 	spi_send_byte(0xFF);
 	return 0;
 };
+
+uint32_t SD_disk_au_size() {
+	// Reads the SD Status register (ACMD13) and returns the allocation unit size in sectors, 0 if unknown
+	volatile unsigned int* GPIO_0_DATA = (unsigned int*) 0x80000000;
+	unsigned char sd_status[64];
+	uint32_t au_size;
+
+	*GPIO_0_DATA &= ~Pin3; // set CS low
+	sd_cmd(55,0,0x0);
+	char rtv = sd_cmd(13,0,0x0);
+	sd_rcv_byte(); // second byte of R2 response
+	if(rtv != 0x00 || sd_read_data(sd_status, 64)) {
+		*GPIO_0_DATA |= Pin3; // set CS High
+		printf("ACMD13 failed, allocation unit size unknown\n");
+		return 0;
+	}
+
+	// AU_SIZE is SD Status bits [431:428], the upper nibble of byte 10
+	au_size = sd_status[10] >> 4;
+	if(au_size == 0) return 0;
+	if(au_size <= 9) return 32u << (au_size - 1); // 16 KB .. 4 MB, powers of 2
+	switch(au_size) {
+		case 0xA: return 8u  * 2048; // 8 MB
+		case 0xB: return 12u * 2048; // 12 MB
+		case 0xC: return 16u * 2048; // 16 MB
+		case 0xD: return 24u * 2048; // 24 MB
+		case 0xE: return 32u * 2048; // 32 MB
+		default:  return 64u * 2048; // 64 MB
+	}
+}
+
+int SD_disk_erase(uint32_t start_sector, uint32_t end_sector) {
+	// Erases sectors start_sector..end_sector (inclusive) via CMD32/CMD33/CMD38
+	volatile unsigned int* GPIO_0_DATA = (unsigned int*) 0x80000000;
+	const int MAX_ATTEMPTS = 0x100000;
+
+	*GPIO_0_DATA &= ~Pin3; // set CS low
+	int rtv = sd_cmd(32, start_sector, 0);
+	if(rtv == 0x00) rtv = sd_cmd(33, end_sector, 0);
+	if(rtv == 0x00) rtv = sd_cmd(38, 0, 0);
+	if(rtv != 0x00) {
+		*GPIO_0_DATA |= Pin3; // set CS High
+		printf("SD_disk_erase: blocks %d to %d, command responded with 0x%2x\n", start_sector, end_sector, rtv);
+		return -1;
+	}
+
+	// R1b, the card holds MISO low until the erase is done
+	int attempts = 0;
+	while((sd_rcv_byte() == 0x00) && (attempts < MAX_ATTEMPTS)) {
+		attempts++;
+	}
+	*GPIO_0_DATA |= Pin3; // set CS high
+	spi_send_byte(0xFF);
+	if(attempts == MAX_ATTEMPTS) {
+		printf("Attempting erase, stuck in BUSY\n");
+		return -1;
+	}
+	return 0;
+}
@@ -6,8 +6,11 @@ int SD_disk_status();
 int SD_disk_initialize();
 int SD_disk_read(unsigned char*, uint32_t, unsigned int);
 int SD_disk_write(unsigned char* buffer, uint32_t sector_no, unsigned int count);
+uint32_t SD_disk_au_size();
+int SD_disk_erase(uint32_t start_sector, uint32_t end_sector);
 
 // Helper SD functions
 int sd_read_block(unsigned char*, uint32_t);
+int sd_read_data(unsigned char*, int);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,100 @@
+# rle_report.py
+# Encodes BMPs the way the board stores them (image%d.rle, see main.c) and
+# reports the compression ratio and the sectors a slide change has to read.
+# 24/32-bit images are dithered to RGB565 first, as the board does.
+#
+# usage: python3 SLIP/rle_report.py image.bmp [image.bmp ...]
+import struct, sys
+
+WIDTH, HEIGHT = 640, 480
+SEC_SIZE = 512
+RLE_HEADER = 8
+RLE_RUN = 0x8000
+RLE_MAX = 0x7FFF
+RLE_MIN_RUN = 3
+RLE_KEEP = 75
+
+BAYER4 = [[0, 8, 2, 10], [12, 4, 14, 6], [3, 11, 1, 9], [15, 7, 13, 5]]
+
+
+def load_rows(path):
+    # RGB565 rows in file order (bottom-up), as rx_transcode() produces them
+    d = open(path, "rb").read()
+    off, = struct.unpack_from("<I", d, 10)
+    w, h, _, bpp, comp = struct.unpack_from("<iiHHI", d, 18)
+    if (w, h) != (WIDTH, HEIGHT) or bpp not in (16, 24, 32):
+        raise ValueError("%dx%d %d bpp, the board takes 640x480 at 16/24/32 bpp" % (w, h, bpp))
+    step = bpp // 8
+    row_size = (WIDTH * step + 3) & ~3
+    rows = []
+    for r in range(HEIGHT):
+        base = off + r * row_size
+        if bpp == 16:
+            rows.append(list(struct.unpack_from("<%dH" % WIDTH, d, base)))
+            continue
+        y = HEIGHT - 1 - r
+        row = []
+        for x in range(WIDTH):
+            b, g, rr = d[base + x * step:base + x * step + 3]
+            t = BAYER4[y & 3][x & 3]
+            row.append(min(rr + t // 2, 255) >> 3 << 11 | min(g + t // 4, 255) >> 2 << 5 | min(b + t // 2, 255) >> 3)
+        rows.append(row)
+    return rows
+
+
+def repeat(px, i, n):
+    run = 1
+    while i + run < n and run < RLE_MAX and px[i + run] == px[i]:
+        run += 1
+    return run
+
+
+def encode_band(px):
+    # Same token stream as rle_put()
+    out = []
+    i, n = 0, len(px)
+    while i < n:
+        run = repeat(px, i, n)
+        if run >= RLE_MIN_RUN:
+            out += [RLE_RUN | run, px[i]]
+            i += run
+            continue
+        j = i + run
+        while j < n and j - i < RLE_MAX and repeat(px, j, min(n, j + RLE_MIN_RUN)) < RLE_MIN_RUN:
+            j += 1
+        out.append(j - i)
+        out += px[i:j]
+        i = j
+    return out
+
+
+def main():
+    if len(sys.argv) < 2:
+        sys.exit("usage: rle_report.py image.bmp [image.bmp ...]")
+    raw = WIDTH * HEIGHT * 2
+    raw_sec = raw // SEC_SIZE
+    tot_raw = tot_rle = 0
+    print("%-24s %9s %8s %8s %6s" % ("file", "bytes", "ratio", "sectors", "kept"))
+    for path in sys.argv[1:]:
+        try:
+            rows = load_rows(path)
+        except (ValueError, OSError, struct.error) as e:
+            print("%-24s %s" % (path, e))
+            continue
+        words = 0
+        for r in range(0, HEIGHT, 2):
+            # BMP row 2k+1 is the upper one of its band
+            words += len(encode_band(rows[r + 1] + rows[r]))
+        size = RLE_HEADER + 2 * words
+        kept = size < raw * RLE_KEEP // 100
+        tot_raw += raw
+        tot_rle += size if kept else raw
+        print("%-24s %9d %7.1f%% %8d %6s" % (path, size, 100.0 * size / raw,
+                                              (size + SEC_SIZE - 1) // SEC_SIZE, "rle" if kept else "fb"))
+    if tot_raw:
+        print("corpus: %d of %d bytes stored (%.1f%%), %d raw sectors per slide" %
+              (tot_rle, tot_raw, 100.0 * tot_rle / tot_raw, raw_sec))
+
+
+if __name__ == "__main__":
+    main()
@@ -1,5 +1,5 @@
 # x07_send_no_ack.py
-import os, struct, serial, time
+import os, struct, serial, time, zlib
 
 # Special Byte
 END = 0xC0
@@ -10,24 +10,22 @@ ESC_ESC = 0xDD
 # Frame type
 TYPE_META = 0x01
 TYPE_DATA = 0x02
+TYPE_DELTA = 0x03
+MAX_CHUNK = 1024        # largest DATA payload the device takes, its UART ring holds one escaped frame
 
-# First frame flag
-is_first_frame = 1
+# Dirty rectangles (META version 2), as the device keeps them
+DIRTY_MAX = 4
+DIRTY_TILE = 16
 
-def wait_ack():
-    buf = bytearray()
-    while True# x07_send_no_ack.py
-import os, struct, serial, time
+# Tile patches (TYPE_DELTA): records of a tile index, then 16 RGB565 rows top-down
+TILE = 16
+TILE_REC = 2 + TILE * TILE * 2
+DELTA_INPLACE = 0x01
+DELTA_MAX = 0.5         # a patch larger than this share of the file is sent whole
 
-# Special Byte
-END = 0xC0
-ESC = 0xDB
-ESC_END = 0xDC
-ESC_ESC = 0xDD
-
-# Frame type
-TYPE_META = 0x01
-TYPE_DATA = 0x02
+# Record of what the device holds: a copy of each BMP sent, named by its
+# CRC-32, and index.txt listing them oldest first, as many as the catalog keeps
+MAX_PHOTOS = 32
 
 def wait_ack(ser):
     buf = bytearray()
@@ -38,8 +36,8 @@ def wait_ack(ser):
         buf += tmp_buf
         if len(buf) > 3:
             buf = buf[-3:]
-        if buf == b"ACK":
-            return
+        if buf in (b"ACK", b"END", b"BAD"):  # END acknowledges the last DATA frame
+            return bytes(buf)
 
 def slip_encode(payload: bytes) -> bytes:
     out = bytearray([END])
@@ -53,31 +51,131 @@ def slip_encode(payload: bytes) -> bytes:
     out.append(END)
     return bytes(out)
 
-def send_file(port: str, baud: int, path: str, chunk: int = 1024, inter_frame_sleep: float = 0.0):
-    ser = serial.Serial(port, baudrate=baud, bytesize=8, parity="N", stopbits=1, timeout=0.1)
-    ser.reset_input_buffer(); 
-    ser.reset_output_buffer()
-    time.sleep(0.1)
+def bmp_rows(data: bytes):
+    # (width, height, bytes per pixel, pixel rows top-down), None if not an uncompressed 16/24/32 bpp BMP
+    if len(data) < 54 or data[:2] != b"BM":
+        return None
+    off, = struct.unpack_from("<I", data, 10)
+    w, h, _, bpp, comp = struct.unpack_from("<iiHHI", data, 18)
+    if bpp not in (16, 24, 32) or comp not in (0, 3) or w <= 0 or h == 0:
+        return None
+    stride = (w * bpp + 31) // 32 * 4
+    rows = [data[off + r * stride: off + r * stride + w * bpp // 8] for r in range(abs(h))]
+    return w, abs(h), bpp // 8, rows[::-1] if h > 0 else rows
 
-    data = open(path, "rb").read()
-    name_bytes = os.path.basename(path).encode("utf-8")[:255]
-    file_id = int.from_bytes(os.urandom(4), "little")
-    chunk = max(64, min(chunk, 4096))
+def dirty_rects(prev: bytes, cur: bytes, max_rects: int = DIRTY_MAX):
+    # Rectangles (x, y, w, h) covering every pixel where cur differs from prev,
+    # at most max_rects of them. None when the images cannot be compared.
+    a, b = bmp_rows(prev), bmp_rows(cur)
+    if not a or not b or a[:3] != b[:3]:
+        return None
+    w, h, bpp, ra = a
+    rb = b[3]
+    tw = (w + DIRTY_TILE - 1) // DIRTY_TILE
+    th = (h + DIRTY_TILE - 1) // DIRTY_TILE
 
-    # META
-    meta = struct.pack("<BBIIHB", TYPE_META, 1, file_id, len(data), chunk, len(name_bytes)) + name_bytes
-    ser.write(slip_encode(meta))
-    wait_ack(ser)
-    print(f"[META] fid=0x{file_id:08x} size={len(data)} chunk={chunk} name={name_bytes.decode(errors='ignore')}")
+    # One band per run of tile rows with changes, spanning its changed tile columns
+    bands = []
+    for ty in range(th):
+        cols = set()
+        for y in range(ty * DIRTY_TILE, min(h, (ty + 1) * DIRTY_TILE)):
+            if ra[y] == rb[y]:
+                continue
+            for tx in range(tw):
+                lo, hi = tx * DIRTY_TILE * bpp, min(w, (tx + 1) * DIRTY_TILE) * bpp
+                if ra[y][lo:hi] != rb[y][lo:hi]:
+                    cols.add(tx)
+        if not cols:
+            continue
+        x0, x1 = min(cols), max(cols) + 1
+        if bands and bands[-1][3] == ty:
+            bx0, by0, bx1, _ = bands[-1]
+            bands[-1] = (min(bx0, x0), by0, max(bx1, x1), ty + 1)
+        else:
+            bands.append((x0, ty, x1, ty + 1))
 
-    # DATA 
+    # Merge the neighbouring pair that adds the least area until they fit
+    def area(r):
+        return (r[2] - r[0]) * (r[3] - r[1])
+    def union(r, q):
+        return (min(r[0], q[0]), min(r[1], q[1]), max(r[2], q[2]), max(r[3], q[3]))
+    while len(bands) > max_rects:
+        costs = [area(union(bands[i], bands[i + 1])) - area(bands[i]) - area(bands[i + 1]) for i in range(len(bands) - 1)]
+        i = costs.index(min(costs))
+        bands[i:i + 2] = [union(bands[i], bands[i + 1])]
+
+    rects = []
+    for x0, y0, x1, y1 in bands:
+        x, y = x0 * DIRTY_TILE, y0 * DIRTY_TILE
+        rects.append((x, y, min(w, x1 * DIRTY_TILE) - x, min(h, y1 * DIRTY_TILE) - y))
+    return rects
+
+def tile_diff(prev: bytes, cur: bytes):
+    # Records of the 16x16 tiles where cur differs from prev, None unless both are 640x480 RGB565
+    a, b = bmp_rows(prev), bmp_rows(cur)
+    if not a or not b or a[:3] != (640, 480, 2) or b[:3] != (640, 480, 2):
+        return None
+    ra, rb = a[3], b[3]
+    recs = []
+    for ty in range(480 // TILE):
+        rows = range(ty * TILE, (ty + 1) * TILE)
+        if all(ra[y] == rb[y] for y in rows):
+            continue
+        for tx in range(640 // TILE):
+            lo, hi = tx * TILE * 2, (tx + 1) * TILE * 2
+            if any(ra[y][lo:hi] != rb[y][lo:hi] for y in rows):
+                recs.append(struct.pack("<H", ty * (640 // TILE) + tx) + b"".join(rb[y][lo:hi] for y in rows))
+    return recs
+
+def record_load(state: str):
+    try:
+        return [int(v, 16) for v in open(os.path.join(state, "index.txt")).read().split()]
+    except OSError:
+        return []
+
+def record_save(state: str, crcs):
+    crcs = crcs[-MAX_PHOTOS:]
+    os.makedirs(state, exist_ok=True)
+    open(os.path.join(state, "index.txt"), "w").write("".join("%08x\n" % c for c in crcs))
+    keep = set("%08x.bmp" % c for c in crcs)
+    for name in os.listdir(state):
+        if name.endswith(".bmp") and name not in keep:
+            os.remove(os.path.join(state, name))
+
+def record_add(state: str, data: bytes, replace: int = None):
+    crcs = [c for c in record_load(state) if c != replace]
+    crc = zlib.crc32(data)
+    if crc in crcs:
+        crcs.remove(crc)
+    os.makedirs(state, exist_ok=True)
+    open(os.path.join(state, "%08x.bmp" % crc), "wb").write(data)
+    record_save(state, crcs + [crc])
+
+def delta_base(state: str, data: bytes):
+    # (crc, tile records) of the recorded image the smallest patch turns into data, or None
+    best = None
+    for crc in reversed(record_load(state)):
+        try:
+            prev = open(os.path.join(state, "%08x.bmp" % crc), "rb").read()
+        except OSError:
+            continue
+        recs = tile_diff(prev, data)
+        if recs is not None and (best is None or len(recs) < len(best[1])):
+            best = (crc, recs)
+    if best is None or len(best[1]) * TILE_REC > DELTA_MAX * len(data):
+        return None
+    return best
+
+def send_data(ser, file_id: int, data: bytes, chunk: int, inter_frame_sleep: float = 0.0):
+    # DATA frames of data, returns the number sent or None when the device gave up
     off, seq, total = 0, 0, len(data)
-    t0 = time.time()
     while off < total:
         pt = data[off: off + chunk]
         header = struct.pack("<BIIH", TYPE_DATA, file_id, seq, len(pt))
         ser.write(slip_encode(header + pt))
-        wait_ack(ser)
+        if wait_ack(ser) == b"BAD":
+            print(f"\n[BAD] device dropped the transfer at {off}/{total} bytes")
+            return None
         off += len(pt); seq += 1
 
         if inter_frame_sleep > 0:
@@ -85,50 +183,10 @@ def send_file(port: str, baud: int, path: str, chunk: int = 1024, inter_frame_sl
 
         if seq % 16 == 0 or off == total:
             print(f"\r[DATA] {off}/{total} bytes sent", end="", flush=True)
+    return seq
 
-    dt = time.time() - t0
-    print(f"\n[DONE] {total} bytes in {dt:.3f}s ({(total/1024.0)/max(dt,1e-9):.1f} KB/s, frames={seq})")
-    ser.close()
-    return 0
-
-if __name__ == "__main__":
-    import argparse
-    ap = argparse.ArgumentParser(description="SLIP Sender (no ACK)")
-    ap.add_argument("--port", required=True, help="Serial port (e.g. /dev/ttys019)")
-    ap.add_argument("--baud", type=int, default=115200, help="Baud rate")
-    ap.add_argument("--file", required=True, help="File path to send")
-    ap.add_argument("--chunk", type=int, default=1024, help="Chunk size (64..4096)")
-    # ap.add_argument("—-ifsleep", type=float, default=0.0, help="Sleep seconds between frames")
-    args = ap.parse_args()
-
-    # rc = send_file(args.port, args.baud, args.file, args.chunk, args.ifsleep)
-    rc = send_file(args.port, args.baud, args.file, args.chunk)
-    raise SystemExit(rc):
-        tmp_buf = ser.read(1)
-        if not tmp_buf:
-            continue
-        buf += tmp_buf
-        if len(buf) > 4:
-            buf = buf[-4:]
-        if buf == b"ACK":
-            return
-        if buf == b"END":
-            is_first_frame = 1
-            return
-
-def slip_encode(payload: bytes) -> bytes:
-    out = bytearray([END])
-    for b in payload:
-        if b == END:
-            out += bytes([ESC, ESC_END])
-        elif b == ESC:
-            out += bytes([ESC, ESC_ESC])
-        else:
-            out.append(b)
-    out.append(END)
-    return bytes(out)
-
-def send_file(port: str, baud: int, path: str, chunk: int = 1024, inter_frame_sleep: float = 0.0):
+def send_file(port: str, baud: int, path: str, chunk: int = 1024, inter_frame_sleep: float = 0.0, prev: str = None,
+              state: str = None, delta: bool = False, inplace: bool = False):
     ser = serial.Serial(port, baudrate=baud, bytesize=8, parity="N", stopbits=1, timeout=0.1)
     ser.reset_input_buffer(); 
     ser.reset_output_buffer()
@@ -137,36 +195,60 @@ def send_file(port: str, baud: int, path: str, chunk: int = 1024, inter_frame_sl
     data = open(path, "rb").read()
     name_bytes = os.path.basename(path).encode("utf-8")[:255]
     file_id = int.from_bytes(os.urandom(4), "little")
-    chunk = max(64, min(chunk, 4096))
-
-    # META
-    meta = struct.pack("<BBIIHB", TYPE_META, 1, file_id, len(data), chunk, len(name_bytes)) + name_bytes
-    if (is_first_frame):
-        ser.write(slip_encode(meta))
-        is_first_frame = 0
-    else:
-        ser.write(slip_encode(meta))
-        wait_ack(ser)
+    chunk = max(64, min(chunk, MAX_CHUNK))
+
+    # DELTA: only the tiles that changed against an image the device holds
+    base = delta_base(state, data) if state and delta else None
+    if base:
+        crc, recs = base
+        patch = b"".join(recs)
+        flags = DELTA_INPLACE if inplace else 0
+        frame = struct.pack("<BBIIHIIB", TYPE_DELTA, 1, file_id, len(patch), chunk, crc, zlib.crc32(data), flags)
+        ser.write(slip_encode(frame))
+        if wait_ack(ser) == b"ACK":
+            print(f"[DELTA] fid=0x{file_id:08x} {len(recs)} tiles against {crc:08x}, {len(patch)} of {len(data)} bytes")
+            t0 = time.time()
+            frames = send_data(ser, file_id, patch, chunk, inter_frame_sleep)
+            if frames is None:
+                ser.close()
+                return 1
+            dt = time.time() - t0
+            print(f"\n[DONE] {len(patch)} bytes in {dt:.3f}s (frames={frames})")
+            record_add(state, data, replace=crc if inplace else None)
+            ser.close()
+            return 0
+        print(f"[DELTA] device does not hold {crc:08x}, sending the whole image")
+        record_save(state, [c for c in record_load(state) if c != crc])
+        file_id = int.from_bytes(os.urandom(4), "little")
+
+    # META, version 2 when the slide before it is known: the device then only
+    # repaints where the two differ
+    prev_data = open(prev, "rb").read() if prev else None
+    rects = dirty_rects(prev_data, data) if prev else None
+    meta = struct.pack("<BBIIHB", TYPE_META, 1 if rects is None else 2, file_id, len(data), chunk, len(name_bytes)) + name_bytes
+    if rects is not None:
+        meta += struct.pack("<IB", zlib.crc32(prev_data), len(rects))
+        meta += b"".join(struct.pack("<HHHH", *r) for r in rects)
+        print(f"[META] {len(rects)} dirty rects against {os.path.basename(prev)}: {rects}")
+    ser.write(slip_encode(meta))
+    if wait_ack(ser) == b"BAD":
+        print(f"[BAD] device refused the transfer (chunk {chunk})")
+        ser.close()
+        return 1
     print(f"[META] fid=0x{file_id:08x} size={len(data)} chunk={chunk} name={name_bytes.decode(errors='ignore')}")
 
     # DATA 
-    off, seq, total = 0, 0, len(data)
+    total = len(data)
     t0 = time.time()
-    while off < total:
-        pt = data[off: off + chunk]
-        header = struct.pack("<BIIH", TYPE_DATA, file_id, seq, len(pt))
-        ser.write(slip_encode(header + pt))
-        wait_ack(ser)
-        off += len(pt); seq += 1
-
-        if inter_frame_sleep > 0:
-            time.sleep(inter_frame_sleep)
-
-        if seq % 16 == 0 or off == total:
-            print(f"\r[DATA] {off}/{total} bytes sent", end="", flush=True)
+    seq = send_data(ser, file_id, data, chunk, inter_frame_sleep)
+    if seq is None:
+        ser.close()
+        return 1
 
     dt = time.time() - t0
     print(f"\n[DONE] {total} bytes in {dt:.3f}s ({(total/1024.0)/max(dt,1e-9):.1f} KB/s, frames={seq})")
+    if state:
+        record_add(state, data)
     ser.close()
     return 0
 
@@ -176,9 +258,15 @@ if __name__ == "__main__":
     ap.add_argument("--port", required=True, help="Serial port (e.g. /dev/ttys019)")
     ap.add_argument("--baud", type=int, default=115200, help="Baud rate")
     ap.add_argument("--file", required=True, help="File path to send")
-    ap.add_argument("--chunk", type=int, default=1024, help="Chunk size (64..4096)")
-    ap.add_argument("—ifsleep", type=float, default=0.0, help="Sleep seconds between frames")
+    ap.add_argument("--chunk", type=int, default=1024, help=f"Chunk size (64..{MAX_CHUNK})")
+    ap.add_argument("--prev", help="BMP sent just before this one, only the regions that differ are repainted")
+    ap.add_argument("--state", default="x07_device", help="Directory recording the images the device holds")
+    ap.add_argument("--delta", action="store_true", help="Send only the 16x16 tiles that differ from a recorded image")
+    ap.add_argument("--inplace", action="store_true", help="With --delta, replace that image instead of adding a copy")
+    # ap.add_argument("—-ifsleep", type=float, default=0.0, help="Sleep seconds between frames")
     args = ap.parse_args()
 
-    rc = send_file(args.port, args.baud, args.file, args.chunk, args.ifsleep)
-    raise SystemExit(rc)
\ No newline at end of file
+    # rc = send_file(args.port, args.baud, args.file, args.chunk, args.ifsleep)
+    rc = send_file(args.port, args.baud, args.file, args.chunk, prev=args.prev,
+                   state=args.state, delta=args.delta, inplace=args.inplace)
+    raise SystemExit(rc)
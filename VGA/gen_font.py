@@ -0,0 +1,98 @@
+# gen_font.py
+# Emits vga_font.sv, the glyph ROM of the vga_ahb text overlay, from the
+# classic 5x7 LCD font below. Each glyph sits in an 8x8 cell, one column
+# of space on the left and one row below, so adjacent cells never touch.
+#
+# usage: python3 VGA/gen_font.py [-o VGA/vga_font.sv] [--show TEXT]
+import os, sys, argparse
+
+FIRST = 0x20
+CELL_W = 8
+CELL_H = 8
+
+# Column-major, bit 0 at the top, 0x20 to 0x7F (0x7F is a solid block,
+# for progress bars)
+GLYPHS = [
+    (0x00, 0x00, 0x00, 0x00, 0x00), (0x00, 0x00, 0x5F, 0x00, 0x00), (0x00, 0x07, 0x00, 0x07, 0x00), (0x14, 0x7F, 0x14, 0x7F, 0x14),
+    (0x24, 0x2A, 0x7F, 0x2A, 0x12), (0x23, 0x13, 0x08, 0x64, 0x62), (0x36, 0x49, 0x55, 0x22, 0x50), (0x00, 0x05, 0x03, 0x00, 0x00),
+    (0x00, 0x1C, 0x22, 0x41, 0x00), (0x00, 0x41, 0x22, 0x1C, 0x00), (0x14, 0x08, 0x3E, 0x08, 0x14), (0x08, 0x08, 0x3E, 0x08, 0x08),
+    (0x00, 0x50, 0x30, 0x00, 0x00), (0x08, 0x08, 0x08, 0x08, 0x08), (0x00, 0x60, 0x60, 0x00, 0x00), (0x20, 0x10, 0x08, 0x04, 0x02),
+    (0x3E, 0x51, 0x49, 0x45, 0x3E), (0x00, 0x42, 0x7F, 0x40, 0x00), (0x42, 0x61, 0x51, 0x49, 0x46), (0x21, 0x41, 0x45, 0x4B, 0x31),
+    (0x18, 0x14, 0x12, 0x7F, 0x10), (0x27, 0x45, 0x45, 0x45, 0x39), (0x3C, 0x4A, 0x49, 0x49, 0x30), (0x01, 0x71, 0x09, 0x05, 0x03),
+    (0x36, 0x49, 0x49, 0x49, 0x36), (0x06, 0x49, 0x49, 0x29, 0x1E), (0x00, 0x36, 0x36, 0x00, 0x00), (0x00, 0x56, 0x36, 0x00, 0x00),
+    (0x08, 0x14, 0x22, 0x41, 0x00), (0x14, 0x14, 0x14, 0x14, 0x14), (0x00, 0x41, 0x22, 0x14, 0x08), (0x02, 0x01, 0x51, 0x09, 0x06),
+    (0x32, 0x49, 0x79, 0x41, 0x3E), (0x7E, 0x11, 0x11, 0x11, 0x7E), (0x7F, 0x49, 0x49, 0x49, 0x36), (0x3E, 0x41, 0x41, 0x41, 0x22),
+    (0x7F, 0x41, 0x41, 0x22, 0x1C), (0x7F, 0x49, 0x49, 0x49, 0x41), (0x7F, 0x09, 0x09, 0x09, 0x01), (0x3E, 0x41, 0x49, 0x49, 0x7A),
+    (0x7F, 0x08, 0x08, 0x08, 0x7F), (0x00, 0x41, 0x7F, 0x41, 0x00), (0x20, 0x40, 0x41, 0x3F, 0x01), (0x7F, 0x08, 0x14, 0x22, 0x41),
+    (0x7F, 0x40, 0x40, 0x40, 0x40), (0x7F, 0x02, 0x0C, 0x02, 0x7F), (0x7F, 0x04, 0x08, 0x10, 0x7F), (0x3E, 0x41, 0x41, 0x41, 0x3E),
+    (0x7F, 0x09, 0x09, 0x09, 0x06), (0x3E, 0x41, 0x51, 0x21, 0x5E), (0x7F, 0x09, 0x19, 0x29, 0x46), (0x46, 0x49, 0x49, 0x49, 0x31),
+    (0x01, 0x01, 0x7F, 0x01, 0x01), (0x3F, 0x40, 0x40, 0x40, 0x3F), (0x1F, 0x20, 0x40, 0x20, 0x1F), (0x3F, 0x40, 0x38, 0x40, 0x3F),
+    (0x63, 0x14, 0x08, 0x14, 0x63), (0x07, 0x08, 0x70, 0x08, 0x07), (0x61, 0x51, 0x49, 0x45, 0x43), (0x00, 0x7F, 0x41, 0x41, 0x00),
+    (0x02, 0x04, 0x08, 0x10, 0x20), (0x00, 0x41, 0x41, 0x7F, 0x00), (0x04, 0x02, 0x01, 0x02, 0x04), (0x40, 0x40, 0x40, 0x40, 0x40),
+    (0x00, 0x01, 0x02, 0x04, 0x00), (0x20, 0x54, 0x54, 0x54, 0x78), (0x7F, 0x48, 0x44, 0x44, 0x38), (0x38, 0x44, 0x44, 0x44, 0x20),
+    (0x38, 0x44, 0x44, 0x48, 0x7F), (0x38, 0x54, 0x54, 0x54, 0x18), (0x08, 0x7E, 0x09, 0x01, 0x02), (0x0C, 0x52, 0x52, 0x52, 0x3E),
+    (0x7F, 0x08, 0x04, 0x04, 0x78), (0x00, 0x44, 0x7D, 0x40, 0x00), (0x20, 0x40, 0x44, 0x3D, 0x00), (0x7F, 0x10, 0x28, 0x44, 0x00),
+    (0x00, 0x41, 0x7F, 0x40, 0x00), (0x7C, 0x04, 0x18, 0x04, 0x78), (0x7C, 0x08, 0x04, 0x04, 0x78), (0x38, 0x44, 0x44, 0x44, 0x38),
+    (0x7C, 0x14, 0x14, 0x14, 0x08), (0x08, 0x14, 0x14, 0x18, 0x7C), (0x7C, 0x08, 0x04, 0x04, 0x08), (0x48, 0x54, 0x54, 0x54, 0x20),
+    (0x04, 0x3F, 0x44, 0x40, 0x20), (0x3C, 0x40, 0x40, 0x20, 0x7C), (0x1C, 0x20, 0x40, 0x20, 0x1C), (0x3C, 0x40, 0x30, 0x40, 0x3C),
+    (0x44, 0x28, 0x10, 0x28, 0x44), (0x0C, 0x50, 0x50, 0x50, 0x3C), (0x44, 0x64, 0x54, 0x4C, 0x44), (0x00, 0x08, 0x36, 0x41, 0x00),
+    (0x00, 0x00, 0x7F, 0x00, 0x00), (0x00, 0x41, 0x36, 0x08, 0x00), (0x02, 0x01, 0x02, 0x04, 0x02), (0x7F, 0x7F, 0x7F, 0x7F, 0x7F),
+]
+
+
+def glyph_rows(code):
+    # Row bytes of one 8x8 cell, bit 7 the leftmost pixel
+    rows = [0] * CELL_H
+    if FIRST <= code < FIRST + len(GLYPHS):
+        for c, col in enumerate(GLYPHS[code - FIRST]):
+            for r in range(7):
+                if col >> r & 1:
+                    rows[r] |= 0x80 >> (c + 1)
+    return rows
+
+
+MODULE = """// Generated by VGA/gen_font.py, do not edit.
+// Glyph ROM of the text overlay: 128 codes of 8x8 cells, bit 7 is the
+// leftmost pixel. Codes below 0x20 are blank.
+module vga_font (
+    input logic clk,
+    input logic [6:0] code,
+    input logic [2:0] row,
+    output logic [7:0] bits     // registered, one clock after code and row
+);
+
+localparam logic [7:0] FONT [1024] = '{
+%(rows)s
+};
+
+always_ff @(posedge clk) begin
+    bits <= FONT[{code, row}];
+end
+
+endmodule
+"""
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("-o", dest="out", default=os.path.join(os.path.dirname(os.path.abspath(__file__)), "vga_font.sv"))
+    ap.add_argument("--show", help="print TEXT as the overlay draws it instead")
+    args = ap.parse_args()
+
+    if args.show:
+        cells = [glyph_rows(ord(ch) & 0x7F) for ch in args.show]
+        for r in range(CELL_H):
+            print("".join("".join("#" if g[r] & (0x80 >> b) else "." for b in range(CELL_W)) for g in cells))
+        return
+
+    lines = []
+    for code in range(128):
+        rows = glyph_rows(code)
+        sep = "," if code < 127 else ""
+        name = chr(code) if FIRST <= code < 0x7F else "--"
+        lines.append("    " + ", ".join("8'h%02X" % v for v in rows) + sep + "  // %02X %s" % (code, name))
+    open(args.out, "w").write(MODULE % {"rows": "\n".join(lines)})
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,408 @@
+`timescale 1ns/1ps
+
+// Scanout and write FIFO testbench for vga_ahb
+//   1. Rewrites the frame on screen with identical data at full bus rate,
+//      every displayed pixel must still match (no pixel stolen by a write)
+//   2. Writes a new frame, then checks SRAM and a whole displayed frame
+//   3. Paints page 1 through WPAGE, flips FRONT and checks the frame shown
+//   4. Blits a fill and an overlapping copy into page 2 during scanout,
+//      checks the SRAM result and the done interrupt
+//   5. Streams a bottom-up, half-word offset image into a page 2 window
+//   6. Takes two vblank interrupts, each must arrive below the visible
+//      area and advance FRAME by one
+//   7. Shows page 2 through scaled views (4x full screen, 2x centred with
+//      a black border, back to 1:1) and checks a whole frame of each
+//   8. Scrolls page 2 and shifts every line by its own signed HOFS entry,
+//      1:1 and in a 2x view, wrapping at both edges
+//   9. Loads colour LUTs and half brightness, checks the 8-bit DAC levels
+//      of a whole frame, then restores the reset tables
+//  10. Turns on the text overlay with solid and blank glyphs in opaque,
+//      transparent and reprogrammed palette colours, edge cells included
+// Reports the sustained write bandwidth of both passes.
+module tb_vga_ahb;
+    localparam VGA_WIDTH  = 640;
+    localparam VGA_HEIGHT = 480;
+    localparam VGA_VTOTAL = 521;
+    localparam FRAME      = VGA_WIDTH * VGA_HEIGHT;
+    localparam AHB_PERIOD = 17.0;   // ~59 MHz, unrelated to the pixel clock
+
+    logic ahb_clk = 1'b0;
+    logic clk_50 = 1'b0;
+    logic n_rst = 1'b0;
+    always #10 clk_50 = ~clk_50;
+    always #(AHB_PERIOD / 2) ahb_clk = ~ahb_clk;
+
+    // DUT
+    logic [19:0] sram_addr;
+    wire  [15:0] sram_dq;
+    logic sram_ce_n, sram_oe_n, sram_we_n, sram_ub_n, sram_lb_n;
+    logic vga_clk, vga_sync_n, vga_blank_n, vga_hs, vga_vs;
+    logic [7:0] vga_r, vga_g, vga_b;
+    logic irq;
+
+    bus_protocol_if busif();
+
+    vga_ahb dut (
+        .ahb_clk(ahb_clk),
+        .n_rst(n_rst),
+        .clk_50(clk_50),
+        .sram_addr(sram_addr),
+        .sram_dq(sram_dq),
+        .sram_ce_n(sram_ce_n),
+        .sram_oe_n(sram_oe_n),
+        .sram_we_n(sram_we_n),
+        .sram_ub_n(sram_ub_n),
+        .sram_lb_n(sram_lb_n),
+        .vga_clk(vga_clk),
+        .vga_r(vga_r),
+        .vga_g(vga_g),
+        .vga_b(vga_b),
+        .vga_sync_n(vga_sync_n),
+        .vga_blank_n(vga_blank_n),
+        .vga_hs(vga_hs),
+        .vga_vs(vga_vs),
+        .irq(irq),
+        .busif(busif)
+    );
+
+    // SRAM model: asynchronous read, byte-lane writes
+    logic [15:0] mem [1 << 20];
+    assign sram_dq = (!sram_ce_n && !sram_oe_n && sram_we_n) ? mem[sram_addr] : 16'bz;
+    always @(negedge ahb_clk) begin
+        if (!sram_ce_n && !sram_we_n) begin
+            if (!sram_lb_n) mem[sram_addr][7:0] <= sram_dq[7:0];
+            if (!sram_ub_n) mem[sram_addr][15:8] <= sram_dq[15:8];
+        end
+    end
+
+    // Test LUTs: red inverted, green doubled and clipped, blue unchanged
+    function automatic logic [7:0] lut_level(input int ch, input int v);
+        case (ch)
+            0: return 8'(255 - v * 8);
+            1: return (v * 8 > 255) ? 8'd255 : 8'(v * 8);
+            default: return 8'(v);
+        endcase
+    endfunction
+
+    function automatic logic [15:0] pattern(input int i, input bit second);
+        logic [15:0] p = 16'(i) ^ 16'(i >> 5) ^ 16'(i * 7);
+        return second ? ~p : p;
+    endfunction
+
+    // Scanout checker, with view_check set it expects page 2 through the view below
+    bit checking = 0;
+    bit second = 0;
+    bit view_check = 0;
+    int view_x0, view_y0, view_w, view_h, view_s;
+    int scroll_x = 0, scroll_y = 0;
+    int hofs [VGA_HEIGHT];
+    bit lut_check = 0;      // expect lut_level() at half brightness on all 8 bits
+    bit txt_check = 0;      // expect the overlay cells below over the image
+    logic [15:0] txt [1200];
+    logic [15:0] txt_pal [16] = '{16'hF81F, 16'h0000, 16'h0015, 16'h0540, 16'h0555, 16'hA800, 16'hA815, 16'hAAA0,
+                                  16'h5AAB, 16'h52BF, 16'h57EA, 16'h57FF, 16'hFAAA, 16'hFABF, 16'hFFEA, 16'hFFFF};
+    int checked = 0;
+    int errors = 0;
+    always @(posedge vga_clk) begin
+        if (checking && vga_blank_n) begin
+            logic [15:0] got, exp;
+            logic [23:0] got24, exp24;
+            int vx, vy;
+            got = {vga_r[7:3], vga_g[7:2], vga_b[7:3]};
+            exp = pattern(dut.vga_y * VGA_WIDTH + dut.vga_x, second);
+            if (view_check) begin
+                vx = dut.vga_x - view_x0;
+                vy = dut.vga_y - view_y0;
+                if (vx >= 0 && vy >= 0 && (vx >> view_s) < view_w && (vy >> view_s) < view_h) begin
+                    vx = ((vx >> view_s) + scroll_x + hofs[dut.vga_y] + view_w) % view_w;
+                    vy = ((vy >> view_s) + scroll_y) % view_h;
+                    exp = mem[2 * FRAME + vy * VGA_WIDTH + vx];
+                end else
+                    exp = 16'h0;
+            end
+            if (txt_check) begin
+                // Only the solid block (0x7F) and blank glyphs are used: 5x7 of
+                // the 8x8 cell, drawn 2x, one blank column on the left
+                logic [15:0] c, col;
+                int gx, gy;
+                c = txt[(dut.vga_y / 16) * 40 + dut.vga_x / 16];
+                gx = dut.vga_x % 16 / 2;
+                gy = dut.vga_y % 16 / 2;
+                col = (c[6:0] == 7'h7F && gx >= 1 && gx <= 5 && gy < 7) ? txt_pal[c[11:8]] : txt_pal[c[15:12]];
+                if (col != txt_pal[0]) exp = col;
+            end
+            checked++;
+            if (lut_check) begin
+                got24 = {vga_r, vga_g, vga_b};
+                exp24 = {lut_level(0, exp[15:11]) >> 1, lut_level(1, exp[10:5]) >> 1, lut_level(2, exp[4:0]) >> 1};
+                if (got24 !== exp24) begin
+                    if (errors < 10) $display("LUT mismatch at (%0d,%0d): %h != %h", dut.vga_x, dut.vga_y, got24, exp24);
+                    errors++;
+                end
+            end else if (got !== exp) begin
+                if (errors < 10) $display("scanout mismatch at (%0d,%0d): %h != %h", dut.vga_x, dut.vga_y, got, exp);
+                errors++;
+            end
+        end
+    end
+
+    // Bus master
+    longint stall_cycles;
+    task automatic bus_write(input logic [31:0] addr, input logic [31:0] data);
+        @(negedge ahb_clk);
+        busif.wen = 1'b1;
+        busif.ren = 1'b0;
+        busif.addr = addr;
+        busif.wdata = data;
+        busif.strobe = 4'hF;
+        #1;
+        while (busif.request_stall) begin
+            stall_cycles++;
+            @(negedge ahb_clk);
+            #1;
+        end
+        @(posedge ahb_clk);
+    endtask
+
+    task automatic bus_read(input logic [31:0] addr, output logic [31:0] data);
+        @(negedge ahb_clk);
+        busif.wen = 1'b0;
+        busif.ren = 1'b1;
+        busif.addr = addr;
+        #1;
+        data = busif.rdata;
+        @(posedge ahb_clk);
+        @(negedge ahb_clk);
+        busif.ren = 1'b0;
+    endtask
+
+    task automatic bus_idle();
+        @(negedge ahb_clk);
+        busif.wen = 1'b0;
+    endtask
+
+    task automatic wait_frame_start();
+        wait (dut.vga_y == VGA_VTOTAL - 1);
+        wait (dut.vga_y == 0 && dut.vga_x == 0);
+    endtask
+
+    // Shows page 2 through a view and checks one whole frame of it
+    task automatic view_test(input int x0, input int y0, input int w, input int h, input int s);
+        logic [31:0] front;
+        bus_write(32'h0040_0008, {6'd0, 10'(y0), 6'd0, 10'(x0)});
+        bus_write(32'h0040_000C, {6'd0, 10'(h), 6'd0, 10'(w)});
+        bus_write(32'h0040_003C, s);
+        bus_write(32'h0040_0000, 32'd2);
+        bus_idle();
+        do bus_read(32'h0040_0000, front); while (front[8]);
+        view_x0 = x0;
+        view_y0 = y0;
+        view_w = w;
+        view_h = h;
+        view_s = s;
+        view_check = 1;
+        wait_frame_start();
+        checking = 1;
+        wait_frame_start();
+        checking = 0;
+        view_check = 0;
+    endtask
+
+    // Loads SCROLL and one signed HOFS entry per line, taken from the next frame
+    task automatic scroll_set(input int x, input int y, input int amp);
+        for (int i = 0; i < VGA_HEIGHT; i++) begin
+            hofs[i] = (i % 9 - 4) * amp;
+            bus_write(32'h0040_0800 + i * 4, 32'(hofs[i]) & 32'h3FF);
+        end
+        bus_write(32'h0040_0040, {6'd0, 10'(y), 6'd0, 10'(x)});
+        bus_idle();
+        scroll_x = x;
+        scroll_y = y;
+    endtask
+
+    task automatic report(input string name, input int writes);
+        $display("%s: %0d writes, %0d stall cycles, %0.3f writes/cycle",
+                 name, writes, stall_cycles, real'(writes) / real'(writes + stall_cycles));
+    endtask
+
+    int mem_errors = 0;
+    initial begin
+        for (int i = 0; i < VGA_HEIGHT; i++) hofs[i] = 0;
+        busif.wen = 1'b0;
+        busif.ren = 1'b0;
+        busif.addr = '0;
+        busif.wdata = '0;
+        busif.strobe = '0;
+        for (int i = 0; i < FRAME; i++) mem[i] = pattern(i, 0);
+        #100 n_rst = 1'b1;
+
+        // The first frame has no prefetched line 0
+        wait_frame_start();
+        checking = 1;
+
+        // 1. Same data through both apertures while the frame is on screen
+        stall_cycles = 0;
+        for (int i = 0; i < FRAME; i += 2)
+            bus_write(32'h0020_0000 + i * 2, {pattern(i + 1, 0), pattern(i, 0)});
+        report("packed rewrite", FRAME / 2);
+        stall_cycles = 0;
+        for (int i = 0; i < FRAME / 4; i++)
+            bus_write(i * 4, {16'h0, pattern(i, 0)});
+        report("pixel rewrite", FRAME / 4);
+        bus_idle();
+        checking = 0;
+
+        // 2. New frame, then one complete frame of it on screen
+        stall_cycles = 0;
+        for (int i = 0; i < FRAME; i += 2)
+            bus_write(32'h0020_0000 + i * 2, {pattern(i + 1, 1), pattern(i, 1)});
+        report("packed new frame", FRAME / 2);
+        bus_idle();
+        repeat (64) @(posedge ahb_clk);    // FIFO drained
+        for (int i = 0; i < FRAME; i++) begin
+            if (mem[i] !== pattern(i, 1)) mem_errors++;
+        end
+        second = 1;
+        wait_frame_start();
+        checking = 1;
+        wait_frame_start();
+        checking = 0;
+
+        // 3. Page flip
+        bus_write(32'h0040_0004, 32'd1);
+        for (int i = 0; i < FRAME; i += 2)
+            bus_write(32'h0020_0000 + i * 2, {pattern(i + 1, 0), pattern(i, 0)});
+        bus_write(32'h0040_0000, 32'd1);
+        bus_idle();
+        begin
+            logic [31:0] front;
+            do bus_read(32'h0040_0000, front); while (front[8]);
+            if (front[1:0] != 2'd1) mem_errors++;
+        end
+        for (int i = 0; i < FRAME; i++) begin
+            if (mem[FRAME + i] !== pattern(i, 0)) mem_errors++;
+        end
+        second = 0;
+        wait_frame_start();
+        checking = 1;
+        wait_frame_start();
+        checking = 0;
+
+        // 4. Blitter: fill a 100x50 block at (20,10), then scroll it down
+        //    by 3 rows and right by 5 pixels with one overlapping copy
+        for (int i = 0; i < FRAME; i++) mem[2 * FRAME + i] = 16'h0;
+        bus_write(32'h0040_0014, {2'd0, 2'd2, 6'd0, 10'd10, 6'd0, 10'd20});
+        bus_write(32'h0040_0018, {16'd50, 16'd100});
+        bus_write(32'h0040_001C, 32'h0000_1234);
+        bus_write(32'h0040_0020, 32'h8000_0100);
+        bus_idle();
+        wait (irq);
+        bus_write(32'h0040_0024, 32'h2);
+        bus_write(32'h0040_0010, {2'd0, 2'd2, 6'd0, 10'd10, 6'd0, 10'd20});
+        bus_write(32'h0040_0014, {2'd0, 2'd2, 6'd0, 10'd13, 6'd0, 10'd25});
+        bus_write(32'h0040_0020, 32'h8000_0104);
+        bus_idle();
+        if (irq) mem_errors++;     // done cleared by the write and the start
+        wait (irq);
+        for (int y = 0; y < VGA_HEIGHT; y++) begin
+            for (int x = 0; x < VGA_WIDTH; x++) begin
+                bit in = (x >= 20 && x < 120 && y >= 10 && y < 60) ||
+                         (x >= 25 && x < 125 && y >= 13 && y < 63);
+                if (mem[2 * FRAME + y * VGA_WIDTH + x] !== (in ? 16'h1234 : 16'h0)) mem_errors++;
+            end
+        end
+
+        // 5. Stream window: 64x8 at (100,200), rows bottom-up, pixels
+        //    starting in the high half of the first word
+        bus_write(32'h0040_0028, {2'd0, 2'd2, 6'd0, 10'd200, 6'd0, 10'd100});
+        bus_write(32'h0040_002C, {16'd8, 16'd64});
+        bus_write(32'h0040_0030, 32'h3);
+        bus_write(32'h0060_0000, {pattern(0, 1), 16'hDEAD});
+        for (int i = 1; i < 64 * 8; i += 2)
+            bus_write(32'h0060_0000 + i * 2, {pattern(i + 1, 1), pattern(i, 1)});
+        bus_write(32'h0060_0000, 32'hFFFF_FFFF);    // past the window, dropped
+        bus_idle();
+        repeat (64) @(posedge ahb_clk);
+        for (int i = 0; i < 64 * 8; i++) begin
+            if (mem[2 * FRAME + (207 - i / 64) * VGA_WIDTH + 100 + i % 64] !== pattern(i, 1)) mem_errors++;
+        end
+        if (mem[2 * FRAME + 199 * VGA_WIDTH + 100] !== 16'h0) mem_errors++;
+
+        // 6. Vblank interrupt and frame counter
+        bus_write(32'h0040_0038, 32'h0000_0101);
+        bus_idle();
+        begin
+            logic [31:0] f0, f1;
+            wait (irq);
+            bus_read(32'h0040_0034, f0);
+            bus_write(32'h0040_0038, 32'h0000_0101);
+            bus_idle();
+            wait (irq);
+            if (dut.vga_y < VGA_HEIGHT) mem_errors++;
+            bus_read(32'h0040_0034, f1);
+            if (f1 != f0 + 1) mem_errors++;
+            bus_write(32'h0040_0038, 32'h0000_0001);
+            bus_idle();
+        end
+
+        // 7. Scaled views of page 2
+        for (int i = 0; i < FRAME; i++) mem[2 * FRAME + i] = pattern(i, 1);
+        view_test(0, 0, 160, 120, 2);
+        view_test(220, 190, 100, 50, 1);
+        view_test(0, 0, VGA_WIDTH, VGA_HEIGHT, 0);
+
+        // 8. Scroll and per-line offsets
+        scroll_set(100, 50, 30);
+        view_test(0, 0, VGA_WIDTH, VGA_HEIGHT, 0);
+        scroll_set(3, 45, 1);
+        view_test(220, 190, 100, 50, 1);
+        scroll_set(0, 0, 0);
+        view_test(0, 0, VGA_WIDTH, VGA_HEIGHT, 0);
+
+        // 9. Output LUTs and brightness
+        for (int i = 0; i < 32; i++) begin
+            bus_write(32'h0040_0400 + i * 4, lut_level(0, i));
+            bus_write(32'h0040_0600 + i * 4, lut_level(2, i));
+        end
+        for (int i = 0; i < 64; i++) bus_write(32'h0040_0500 + i * 4, lut_level(1, i));
+        bus_write(32'h0040_0044, 32'd128);
+        bus_idle();
+        lut_check = 1;
+        view_test(0, 0, VGA_WIDTH, VGA_HEIGHT, 0);
+        lut_check = 0;
+        for (int i = 0; i < 32; i++) begin
+            bus_write(32'h0040_0400 + i * 4, {i[4:0], i[4:2]});
+            bus_write(32'h0040_0600 + i * 4, {i[4:0], i[4:2]});
+        end
+        for (int i = 0; i < 64; i++) bus_write(32'h0040_0500 + i * 4, {i[5:0], i[5:4]});
+        bus_write(32'h0040_0044, 32'd256);
+        bus_idle();
+
+        // 10. Text overlay
+        begin
+            logic [31:0] key;
+            bus_read(32'h0040_004C, key);
+            if (key !== 32'h0000_F81F) mem_errors++;
+        end
+        txt_pal[3] = 16'h1234;
+        bus_write(32'h0040_100C, 32'h1234);
+        for (int i = 0; i < 1200; i++) begin
+            txt[i] = 16'h0;
+            if (i / 40 == 0 || i / 40 == 29 || i % 40 == 0 || i % 40 == 39 || i % 7 == 0)
+                txt[i] = {4'(i % 3 ? 1 : 0), 4'(i % 2 ? 15 : 3), 1'b0, (i % 5 < 2) ? 7'h20 : 7'h7F};
+            bus_write(32'h0040_2000 + i * 4, txt[i]);
+        end
+        bus_write(32'h0040_0048, 32'h1);
+        bus_idle();
+        txt_check = 1;
+        view_test(0, 0, VGA_WIDTH, VGA_HEIGHT, 0);
+        txt_check = 0;
+        bus_write(32'h0040_0048, 32'h0);
+        bus_idle();
+
+        $display("checked %0d pixels, %0d scanout errors, %0d SRAM errors", checked, errors, mem_errors);
+        if (errors || mem_errors) $fatal(1, "tb_vga_ahb FAILED");
+        $display("tb_vga_ahb PASSED");
+        $finish;
+    end
+endmodule
@@ -158,6 +158,9 @@ module vga_ahb (
     output logic vga_hs,
     output logic vga_vs,
 
+    // Interrupt (blit done, vblank start)
+    output logic irq,
+
     // Bus
     bus_protocol_if.peripheral_vital busif
 );
@@ -168,6 +171,74 @@ module vga_ahb (
 localparam VGA_WIDTH     = 640;
 localparam VGA_HEIGHT    = 480;
 
+// Address map (byte offsets from the base)
+// 0x000000: pixel aperture, one pixel per word in wdata[15:0]
+// 0x200000: packed aperture, pixel 2n in wdata[15:0] and 2n+1 in wdata[31:16]
+// 0x400000: registers
+//           0x00 FRONT  [1:0] page scanned out from the next frame, [8] flip pending (RO).
+//                       Writing it also hands VIEW_POS/VIEW_SIZE/SCALE to the scanout.
+//           0x04 WPAGE  [1:0] page the pixel and packed apertures write
+//           0x08 VIEW_POS   [9:0] x, [25:16] y of the image on screen, black around it
+//           0x0C VIEW_SIZE  [9:0] width, [25:16] height of the image in the page,
+//                           stored top-left with the usual 640-pixel row pitch
+//           0x10 BLT_SRC    [9:0] x, [25:16] y, [29:28] page
+//           0x14 BLT_DST    [9:0] x, [25:16] y, [29:28] page
+//           0x18 BLT_SIZE   [9:0] width, [25:16] height
+//           0x1C BLT_COLOR  [15:0] RGB565 source of a fill
+//           0x20 BLT_CTRL   [1:0] raster op (S, S&D, S|D, S^D), [2] source is BLT_SRC
+//                           (else BLT_COLOR), [8] done interrupt enable, [31] start (WO)
+//           0x24 BLT_STATUS [0] busy (RO), [1] done (write 1 to clear)
+//           0x28 STRM_POS   [9:0] x, [25:16] y, [29:28] page of the stream window
+//           0x2C STRM_SIZE  [9:0] width, [25:16] height (x and width even)
+//           0x30 STRM_CTRL  [0] vertical flip (first row at the bottom), [1] drop the
+//                           low half of the first word, [8] window full (RO).
+//                           Writing it rewinds the stream.
+//           0x34 FRAME      [31:0] frames started since reset, counts at vblank start (RO)
+//           0x38 VBL_CTRL   [0] vblank started (write 1 to clear), [8] interrupt enable
+//           0x3C SCALE      [1:0] log2 of the integer zoom, each image pixel is shown
+//                           as a 1x1 to 8x8 block
+//           0x40 SCROLL     [9:0] x, [25:16] y of the image pixel shown at the view's
+//                           top-left, below VIEW_SIZE. The image wraps around, and the
+//                           value is taken at the start of every frame.
+//           0x44 BRIGHT     [8:0] output gain after the LUTs, 256 = 1.0
+//           0x48 TXT_CTRL   [0] text overlay enable
+//           0x4C TXT_KEY    [15:0] RGB565 colour left transparent by the overlay
+//           0x400-0x47C LUT_R, 0x500-0x5FC LUT_G, 0x600-0x67C LUT_B (WO): one word
+//                           per 5/6/5-bit field value, [7:0] the 8-bit DAC level.
+//                           Reset to bit replication (full scale at 31 and 63).
+//           0x800-0xF7C HOFS, one word per screen line (WO): [9:0] signed offset
+//                           added to the SCROLL x of that line, smaller than the
+//                           view width either way. Used as the line is fetched.
+//           0x1000-0x103C TXT_PAL, 16 RGB565 overlay colours in [15:0] (WO).
+//                           Entry 0 resets to the key, the rest to the CGA colours.
+//           0x2000-0x32BC TXT, one word per 16x16 cell of the 40x30 overlay grid,
+//                           row-major (WO): [6:0] character, [11:8] foreground and
+//                           [15:12] background TXT_PAL index. Resets to blank cells
+//                           on the transparent entry 0.
+// 0x600000: stream aperture, every write is the next two pixels of the window
+//           regardless of the address, so a flat file (bottom-up BMP rows
+//           included) can be copied or DMAed in with a fixed or rising address
+localparam PACKED_BIT    = 21;
+localparam REG_BIT       = 22;
+localparam HOFS_BIT      = 11;
+localparam LUT_BIT       = 10;
+localparam PAL_BIT       = 12;
+localparam TXT_BIT       = 13;
+
+// Pages: the SRAM holds three 640x480 frames back to back
+localparam PAGE_WORDS    = VGA_WIDTH * VGA_HEIGHT;
+localparam N_PAGES       = 3;
+
+localparam VGA_HTOTAL    = 800;  // pixels per line, vga_controller HVID+HFP+HS+HBP
+localparam VGA_VTOTAL    = 521;  // lines per frame, vga_controller VVID+VFP+VS+VBP
+localparam WFIFO_DEPTH   = 16;   // queued CPU writes, power of 2
+localparam WFIFO_AW      = $clog2(WFIFO_DEPTH);
+
+// Text overlay: 8x8 glyphs drawn 2x, a 40x30 grid over the whole screen
+localparam TXT_COLS      = VGA_WIDTH / 16;
+localparam TXT_ROWS      = VGA_HEIGHT / 16;
+localparam TXT_CELLS     = TXT_COLS * TXT_ROWS;
+
 // =====================================================
 // Internal Signals
 // =====================================================
@@ -189,6 +260,147 @@ logic next_sram_we_n;
 logic next_sram_ub_n;
 logic next_sram_lb_n;
 
+// Write FIFO entry: SRAM word of the low pixel, data and byte enables.
+// One-pixel writes only carry strobe[1:0].
+typedef struct packed {
+    logic [19:0] addr;
+    logic [31:0] data;
+    logic [3:0]  strobe;
+} wr_entry_t;
+
+wr_entry_t wfifo [WFIFO_DEPTH];
+wr_entry_t wr_head;
+logic [WFIFO_AW:0] wr_ptr, rd_ptr, next_rd_ptr;
+logic wfifo_full, wfifo_empty;
+logic wr_push;
+logic drain_hi, next_drain_hi;   // low half of the head entry written
+
+// Registers
+logic [4:0] reg_idx;
+logic [1:0] front_req;      // FRONT as written
+logic [1:0] front_page, next_front_page;
+logic flip_req;             // FRONT written, view and page not taken yet
+logic flip_take;
+
+// Scanout view: as written, and as used from the last flip on
+logic [25:0] view_pos, view_size;
+logic [1:0]  view_scale;
+logic [25:0] scan_pos, next_scan_pos, scan_size, next_scan_size;
+logic [1:0]  scan_scale, next_scan_scale;
+logic [9:0]  scan_dx, scan_dy;  // screen position within the view
+logic        scan_on;           // next pixel lies inside the view
+logic [9:0]  fetch_dy;
+
+// Scroll: SCROLL as written and per frame, one offset per screen line
+logic [25:0] scroll, scan_scroll, next_scan_scroll;
+logic [9:0]  hofs_ram [VGA_HEIGHT];
+logic [9:0]  hofs_q;            // entry of req_line
+logic [10:0] fetch_row;
+logic [11:0] fetch_col;         // signed, within one view width of the range
+logic [1:0] wpage;
+logic [19:0] wpage_base;
+logic fb_wen, reg_wen;
+logic reg_space;            // register page, all tables included
+logic reg_sel;
+logic hofs_wen;
+logic lut_wen;
+logic pal_wen, txt_wen;
+
+// Stream aperture
+logic        strm_sel, strm_wen;
+logic [29:0] strm_pos;
+logic [25:0] strm_size;
+logic        strm_flip;
+logic        strm_skip;     // drop the low half of the first word
+logic        strm_lead;     // low half of the next word still to be dropped
+logic        strm_full;     // every pixel of the window written
+logic [9:0]  strm_x, strm_y;
+logic [19:0] strm_row;      // SRAM word of the row being written
+logic [15:0] strm_carry;    // high half of the last word, first pixel of the next pair
+logic        strm_push;
+
+// Vblank, vga_clk -> ahb_clk
+logic        vbl_tog;
+logic [2:0]  vbl_sync;
+logic [31:0] frame_cnt;
+logic        vbl_pend;
+logic        vbl_irq_en;
+
+// Blitter
+typedef enum logic [2:0] {
+    BLT_IDLE,
+    BLT_RSRC,       // read the source pixel
+    BLT_WSRC,       // source data on the bus
+    BLT_RDST,       // read the destination pixel (raster ops using D)
+    BLT_WDST,       // destination data on the bus
+    BLT_WR          // write the result
+} blt_state_t;
+
+logic [29:0] blt_src, blt_dst;
+logic [25:0] blt_size;
+logic [15:0] blt_color;
+logic [1:0]  blt_rop;
+logic        blt_use_src;
+logic        blt_irq_en;
+logic        blt_done;
+logic        blt_start;
+blt_state_t  blt_state, next_blt_state;
+logic        blt_back;      // walk from the last pixel backwards (overlapping copy)
+logic [9:0]  blt_x, next_blt_x;
+logic [9:0]  blt_y, next_blt_y;
+logic [19:0] blt_scur, next_blt_scur, blt_srow, next_blt_srow;
+logic [19:0] blt_dcur, next_blt_dcur, blt_drow, next_blt_drow;
+logic [15:0] blt_sdata, blt_ddata;
+logic        blt_grant;
+logic        blt_finish;
+logic        blt_rd_src, next_blt_rd_src;   // SRAM read issued last cycle, by the blitter
+logic        blt_rd_dst, next_blt_rd_dst;
+logic [15:0] blt_s, blt_result;
+logic [19:0] blt_src_first, blt_dst_first;
+
+// Output stage: per-channel LUTs from the RGB565 fields, then the gain
+logic [7:0]  lut_r [32];
+logic [7:0]  lut_g [64];
+logic [7:0]  lut_b [32];
+logic [8:0]  bright;
+logic [16:0] out_r, out_g, out_b;
+logic [15:0] out_px;            // pixel or overlay, into the LUTs
+
+// Text overlay: cell and palette tables, then a three-stage read run two
+// pixels ahead of the scanout (cell, glyph row, colour)
+logic        txt_en;
+logic [15:0] txt_key;
+logic [15:0] txt_pal [16];
+logic [15:0] txt_ram [TXT_CELLS];
+logic [9:0]  txt_x, txt_y;      // screen pixel two clocks ahead of next_vga_x
+logic [15:0] txt_cell;
+logic [2:0]  txt_row, txt_col, txt_col_q;
+logic        txt_in, txt_in_q;  // inside the grid
+logic [7:0]  txt_attr;
+logic [7:0]  txt_bits;
+logic [15:0] txt_color;
+logic [15:0] txt_px;
+logic        txt_show;          // txt_px replaces pixel
+
+// Line buffers: the line on screen is read from one, the next is fetched into the other
+logic [15:0] line_buf [2*VGA_WIDTH];
+logic [15:0] pixel;
+
+// Fetch request, vga_clk -> ahb_clk
+logic [9:0] req_line;
+logic req_tog;
+logic [2:0] req_sync;
+
+logic fetch_busy, next_fetch_busy;
+logic fetch_buf, next_fetch_buf;
+logic [9:0] fetch_x, next_fetch_x;
+logic [9:0] fetch_col_at, next_fetch_col_at;    // image column of fetch_addr
+logic [19:0] fetch_addr, next_fetch_addr;
+logic [19:0] fetch_base, next_fetch_base;       // image row being fetched
+logic rd_pend, next_rd_pend;    // SRAM read issued last cycle, data valid now
+logic rd_buf;
+logic [9:0] rd_x;
+
 // =====================================================
 // VGA Controller
 // =====================================================
@@ -234,39 +446,554 @@ end
 // =====================================================
 // AHB Bus Interface
 // =====================================================
+// Writes are queued, the bus only waits when the queue is full
+assign strm_sel = busif.addr[REG_BIT] && busif.addr[PACKED_BIT];
+assign fb_wen = busif.wen && (!busif.addr[REG_BIT] || strm_sel);
+assign reg_space = busif.addr[REG_BIT] && !busif.addr[PACKED_BIT];
+assign reg_sel = reg_space && busif.addr[TXT_BIT:LUT_BIT] == 4'b0000;
+assign reg_wen = busif.wen && reg_sel;
+assign hofs_wen = busif.wen && reg_space && busif.addr[TXT_BIT:HOFS_BIT] == 3'b001;
+assign lut_wen = busif.wen && reg_space && busif.addr[TXT_BIT:LUT_BIT] == 4'b0001;
+assign pal_wen = busif.wen && reg_space && busif.addr[TXT_BIT:PAL_BIT] == 2'b01;
+assign txt_wen = busif.wen && reg_space && busif.addr[TXT_BIT];
+assign strm_wen = busif.wen && strm_sel;
+
 always_comb begin
-    busif.request_stall = 1'b0;
+    busif.request_stall = fb_wen && wfifo_full;
     busif.error = 1'b0;
     busif.rdata = '0;
+
+    if(busif.ren && reg_sel) begin
+        case(reg_idx)
+            5'h00: busif.rdata = {23'b0, flip_req, 6'b0, front_req};
+            5'h01: busif.rdata = {30'b0, wpage};
+            5'h02: busif.rdata = {6'b0, view_pos};
+            5'h03: busif.rdata = {6'b0, view_size};
+            5'h04: busif.rdata = {2'b0, blt_src};
+            5'h05: busif.rdata = {2'b0, blt_dst};
+            5'h06: busif.rdata = {6'b0, blt_size};
+            5'h07: busif.rdata = {16'b0, blt_color};
+            5'h08: busif.rdata = {23'b0, blt_irq_en, 5'b0, blt_use_src, blt_rop};
+            5'h09: busif.rdata = {30'b0, blt_done, blt_state != BLT_IDLE};
+            5'h0A: busif.rdata = {2'b0, strm_pos};
+            5'h0B: busif.rdata = {6'b0, strm_size};
+            5'h0C: busif.rdata = {23'b0, strm_full, 6'b0, strm_skip, strm_flip};
+            5'h0D: busif.rdata = frame_cnt;
+            5'h0E: busif.rdata = {23'b0, vbl_irq_en, 7'b0, vbl_pend};
+            5'h0F: busif.rdata = {30'b0, view_scale};
+            5'h10: busif.rdata = {6'b0, scroll};
+            5'h11: busif.rdata = {23'b0, bright};
+            5'h12: busif.rdata = {31'b0, txt_en};
+            5'h13: busif.rdata = {16'b0, txt_key};
+            default: ;
+        endcase
+    end
 end
 
+assign irq = (blt_done && blt_irq_en) || (vbl_pend && vbl_irq_en);
+
 // =====================================================
-// Frame Buffer Logic
+// Registers
 // =====================================================
-logic [19:0] raddr;
-assign sram_dq = (!sram_we_n) ? sram_wdat : 16'bz;
-assign raddr = (vga_y * VGA_WIDTH) + vga_x;
+assign reg_idx = busif.addr[6:2];
+assign blt_start = reg_wen && reg_idx == 5'h08 && busif.wdata[31] && blt_state == BLT_IDLE;
+
+always_ff @(posedge ahb_clk, negedge n_rst) begin
+    if(!n_rst) begin
+        front_req <= '0;
+        flip_req <= 1'b0;
+        wpage <= '0;
+        view_pos <= '0;
+        view_size <= {10'(VGA_HEIGHT), 6'b0, 10'(VGA_WIDTH)};
+        view_scale <= '0;
+        scroll <= '0;
+        bright <= 9'd256;
+        txt_en <= 1'b0;
+        txt_key <= 16'hF81F;
+        blt_src <= '0;
+        blt_dst <= '0;
+        blt_size <= '0;
+        blt_color <= '0;
+        blt_rop <= '0;
+        blt_use_src <= 1'b0;
+        blt_irq_en <= 1'b0;
+        blt_done <= 1'b0;
+        strm_pos <= '0;
+        strm_size <= '0;
+        strm_flip <= 1'b0;
+        strm_skip <= 1'b0;
+        vbl_pend <= 1'b0;
+        vbl_irq_en <= 1'b0;
+    end else begin
+        if(reg_wen) begin
+            case(reg_idx)
+                5'h00: if(busif.wdata[1:0] < N_PAGES) front_req <= busif.wdata[1:0];
+                5'h01: if(busif.wdata[1:0] < N_PAGES) wpage <= busif.wdata[1:0];
+                5'h02: view_pos <= busif.wdata[25:0];
+                5'h03: begin
+                    view_size[9:0] <= (busif.wdata[9:0] > VGA_WIDTH) ? 10'(VGA_WIDTH) : busif.wdata[9:0];
+                    view_size[25:16] <= (busif.wdata[25:16] > VGA_HEIGHT) ? 10'(VGA_HEIGHT) : busif.wdata[25:16];
+                end
+                5'h04: blt_src <= busif.wdata[29:0];
+                5'h05: blt_dst <= busif.wdata[29:0];
+                5'h06: blt_size <= busif.wdata[25:0];
+                5'h07: blt_color <= busif.wdata[15:0];
+                5'h08: begin
+                    blt_rop <= busif.wdata[1:0];
+                    blt_use_src <= busif.wdata[2];
+                    blt_irq_en <= busif.wdata[8];
+                end
+                5'h09: if(busif.wdata[1]) blt_done <= 1'b0;
+                5'h0A: strm_pos <= busif.wdata[29:0];
+                5'h0B: strm_size <= {busif.wdata[25:16], busif.wdata[9:1], 1'b0};
+                5'h0C: begin
+                    strm_flip <= busif.wdata[0];
+                    strm_skip <= busif.wdata[1];
+                end
+                5'h0E: begin
+                    if(busif.wdata[0]) vbl_pend <= 1'b0;
+                    vbl_irq_en <= busif.wdata[8];
+                end
+                5'h0F: view_scale <= busif.wdata[1:0];
+                5'h10: scroll <= busif.wdata[25:0];
+                5'h11: bright <= (busif.wdata[8:0] > 9'd256) ? 9'd256 : busif.wdata[8:0];
+                5'h12: txt_en <= busif.wdata[0];
+                5'h13: txt_key <= busif.wdata[15:0];
+                default: ;
+            endcase
+        end
+        // A write in the same cycle as the take stays pending for the next frame
+        if(flip_take) flip_req <= 1'b0;
+        if(reg_wen && reg_idx == 5'h00) flip_req <= 1'b1;
+        if(blt_start) blt_done <= 1'b0;
+        if(blt_finish) blt_done <= 1'b1;
+        if(vbl_sync[2] != vbl_sync[1]) vbl_pend <= 1'b1;
+    end
+end
+
+// =====================================================
+// Vblank
+// =====================================================
+// The first line after the visible area toggles vbl_tog, the ahb side
+// counts the frame and raises vbl_pend
+always_ff @(posedge vga_clk) begin
+    if(!n_rst) vbl_tog <= 1'b0;
+    else if(next_vga_x == 0 && vga_x != 0 && next_vga_y == VGA_HEIGHT) vbl_tog <= ~vbl_tog;
+end
+
+always_ff @(posedge ahb_clk, negedge n_rst) begin
+    if(!n_rst) begin
+        vbl_sync <= '0;
+        frame_cnt <= '0;
+    end else begin
+        vbl_sync <= {vbl_sync[1:0], vbl_tog};
+        if(vbl_sync[2] != vbl_sync[1]) frame_cnt <= frame_cnt + 1'b1;
+    end
+end
+
+assign wpage_base = wpage * PAGE_WORDS;
+
+// =====================================================
+// Stream Aperture
+// =====================================================
+// Writes walk the window row by row, two pixels per word. With the flip
+// set the rows go upwards, which is the order of a BMP pixel array. With
+// the skip set the pairs are re-formed one half later, so a BMP whose
+// pixels start at an offset of 2 mod 4 (the 54-byte header) can be moved
+// in whole aligned words.
+assign strm_push = strm_wen && !wfifo_full && !strm_full;
+
+always_ff @(posedge ahb_clk, negedge n_rst) begin
+    if(!n_rst) begin
+        strm_lead <= 1'b0;
+        strm_full <= 1'b1;
+        strm_x <= '0;
+        strm_y <= '0;
+        strm_row <= '0;
+        strm_carry <= '0;
+    end else if(reg_wen && reg_idx == 5'h0C) begin
+        strm_lead <= busif.wdata[1];
+        strm_full <= strm_size[9:0] == 0 || strm_size[25:16] == 0;
+        strm_x <= '0;
+        strm_y <= '0;
+        strm_row <= strm_pos[29:28] * PAGE_WORDS + strm_pos[9:0] +
+                    (busif.wdata[0] ? strm_pos[25:16] + strm_size[25:16] - 1'b1 : strm_pos[25:16]) * VGA_WIDTH;
+    end else if(strm_push) begin
+        strm_carry <= busif.wdata[31:16];
+        if(strm_lead) begin
+            strm_lead <= 1'b0;
+        end else if(strm_x + 2'd2 >= strm_size[9:0]) begin
+            strm_x <= '0;
+            strm_y <= strm_y + 1'b1;
+            strm_row <= strm_flip ? strm_row - VGA_WIDTH : strm_row + VGA_WIDTH;
+            if(strm_y == strm_size[25:16] - 1'b1) strm_full <= 1'b1;
+        end else begin
+            strm_x <= strm_x + 2'd2;
+        end
+    end
+end
+
+// =====================================================
+// Blitter
+// =====================================================
+// Walks the destination rectangle one pixel at a time using SRAM cycles
+// that neither the line fetch nor the write FIFO wants. Copies whose
+// destination lies after the source run backwards, so scrolls within a
+// page do not overwrite source pixels before they are read.
+assign blt_src_first = blt_src[29:28] * PAGE_WORDS + blt_src[25:16] * VGA_WIDTH + blt_src[9:0];
+assign blt_dst_first = blt_dst[29:28] * PAGE_WORDS + blt_dst[25:16] * VGA_WIDTH + blt_dst[9:0];
+assign blt_s = blt_use_src ? blt_sdata : blt_color;
+
+always_comb begin
+    case(blt_rop)
+        2'd0: blt_result = blt_s;
+        2'd1: blt_result = blt_s & blt_ddata;
+        2'd2: blt_result = blt_s | blt_ddata;
+        default: blt_result = blt_s ^ blt_ddata;
+    endcase
+end
+
+always_comb begin
+    next_blt_state = blt_state;
+    next_blt_x = blt_x;
+    next_blt_y = blt_y;
+    next_blt_scur = blt_scur;
+    next_blt_srow = blt_srow;
+    next_blt_dcur = blt_dcur;
+    next_blt_drow = blt_drow;
+    blt_finish = 1'b0;
+
+    case(blt_state)
+        BLT_IDLE: begin
+            if(blt_start) begin
+                // wdata carries the source select of this start
+                next_blt_x = '0;
+                next_blt_y = '0;
+                if(blt_size[9:0] == 0 || blt_size[25:16] == 0) begin
+                    blt_finish = 1'b1;
+                end else if(busif.wdata[2] && blt_dst_first > blt_src_first) begin
+                    next_blt_scur = blt_src_first + (blt_size[25:16] - 1'b1) * VGA_WIDTH + blt_size[9:0] - 1'b1;
+                    next_blt_dcur = blt_dst_first + (blt_size[25:16] - 1'b1) * VGA_WIDTH + blt_size[9:0] - 1'b1;
+                    next_blt_state = BLT_RSRC;
+                end else begin
+                    next_blt_scur = blt_src_first;
+                    next_blt_dcur = blt_dst_first;
+                    next_blt_state = busif.wdata[2] ? BLT_RSRC : (busif.wdata[1:0] != 0 ? BLT_RDST : BLT_WR);
+                end
+                next_blt_srow = next_blt_scur;
+                next_blt_drow = next_blt_dcur;
+            end
+        end
+        BLT_RSRC: if(blt_grant) next_blt_state = BLT_WSRC;
+        BLT_WSRC: next_blt_state = (blt_rop != 0) ? BLT_RDST : BLT_WR;
+        BLT_RDST: if(blt_grant) next_blt_state = BLT_WDST;
+        BLT_WDST: next_blt_state = BLT_WR;
+        BLT_WR: begin
+            if(blt_grant) begin
+                next_blt_state = blt_use_src ? BLT_RSRC : (blt_rop != 0 ? BLT_RDST : BLT_WR);
+                if(blt_x == blt_size[9:0] - 1'b1) begin
+                    next_blt_x = '0;
+                    next_blt_y = blt_y + 1'b1;
+                    next_blt_srow = blt_back ? blt_srow - VGA_WIDTH : blt_srow + VGA_WIDTH;
+                    next_blt_drow = blt_back ? blt_drow - VGA_WIDTH : blt_drow + VGA_WIDTH;
+                    next_blt_scur = next_blt_srow;
+                    next_blt_dcur = next_blt_drow;
+                    if(blt_y == blt_size[25:16] - 1'b1) begin
+                        next_blt_state = BLT_IDLE;
+                        blt_finish = 1'b1;
+                    end
+                end else begin
+                    next_blt_x = blt_x + 1'b1;
+                    next_blt_scur = blt_back ? blt_scur - 1'b1 : blt_scur + 1'b1;
+                    next_blt_dcur = blt_back ? blt_dcur - 1'b1 : blt_dcur + 1'b1;
+                end
+            end
+        end
+        default: next_blt_state = BLT_IDLE;
+    endcase
+end
+
+always_ff @(posedge ahb_clk, negedge n_rst) begin
+    if(!n_rst) begin
+        blt_state <= BLT_IDLE;
+        blt_back <= 1'b0;
+        blt_x <= '0;
+        blt_y <= '0;
+        blt_scur <= '0;
+        blt_srow <= '0;
+        blt_dcur <= '0;
+        blt_drow <= '0;
+        blt_sdata <= '0;
+        blt_ddata <= '0;
+        blt_rd_src <= 1'b0;
+        blt_rd_dst <= 1'b0;
+    end else begin
+        blt_state <= next_blt_state;
+        if(blt_start) blt_back <= busif.wdata[2] && blt_dst_first > blt_src_first;
+        blt_x <= next_blt_x;
+        blt_y <= next_blt_y;
+        blt_scur <= next_blt_scur;
+        blt_srow <= next_blt_srow;
+        blt_dcur <= next_blt_dcur;
+        blt_drow <= next_blt_drow;
+        blt_rd_src <= next_blt_rd_src;
+        blt_rd_dst <= next_blt_rd_dst;
+        if(blt_rd_src) blt_sdata <= sram_dq;
+        if(blt_rd_dst) blt_ddata <= sram_dq;
+    end
+end
+
+// =====================================================
+// Write FIFO
+// =====================================================
+assign wfifo_full = (wr_ptr[WFIFO_AW] != rd_ptr[WFIFO_AW]) && (wr_ptr[WFIFO_AW-1:0] == rd_ptr[WFIFO_AW-1:0]);
+assign wfifo_empty = (wr_ptr == rd_ptr);
+// Stream writes that only fill strm_carry, or land past the window, take no slot
+assign wr_push = fb_wen && !wfifo_full && !(strm_sel && (strm_lead || strm_full));
+assign wr_head = wfifo[rd_ptr[WFIFO_AW-1:0]];
+
+always_ff @(posedge ahb_clk) begin
+    if(wr_push) begin
+        if(strm_sel) begin
+            wfifo[wr_ptr[WFIFO_AW-1:0]] <= '{addr: strm_row + strm_x,
+                                             data: strm_skip ? {busif.wdata[15:0], strm_carry} : busif.wdata,
+                                             strobe: 4'hF};
+        end else if(busif.addr[PACKED_BIT]) begin
+            wfifo[wr_ptr[WFIFO_AW-1:0]] <= '{addr: wpage_base + {busif.addr[20:2], 1'b0}, data: busif.wdata, strobe: busif.strobe};
+        end else begin
+            wfifo[wr_ptr[WFIFO_AW-1:0]] <= '{addr: wpage_base + busif.addr[21:2], data: busif.wdata, strobe: 4'b0011};
+        end
+    end
+end
+
+always_ff @(posedge ahb_clk, negedge n_rst) begin
+    if(!n_rst) wr_ptr <= '0;
+    else if(wr_push) wr_ptr <= wr_ptr + 1'b1;
+end
+
+// =====================================================
+// Scanout Line Fetch
+// =====================================================
+// At the start of each line, ask for the next visible line to be fetched
+always_ff @(posedge vga_clk) begin
+    if(!n_rst) begin
+        req_line <= '0;
+        req_tog <= 1'b0;
+    end else if(next_vga_x == 0 && vga_x != 0) begin
+        if(next_vga_y == VGA_VTOTAL - 1) begin
+            req_line <= '0;
+            req_tog <= ~req_tog;
+        end else if(next_vga_y < VGA_HEIGHT - 1) begin
+            req_line <= next_vga_y + 1'b1;
+            req_tog <= ~req_tog;
+        end
+    end
+end
+
+always_ff @(posedge ahb_clk, negedge n_rst) begin
+    if(!n_rst) req_sync <= '0;
+    else req_sync <= {req_sync[1:0], req_tog};
+end
+
+// Line offsets, written from the bus and read at each line request.
+// req_line has settled by the time req_sync sees the toggle.
+initial begin
+    for(int i = 0; i < VGA_HEIGHT; i++) hofs_ram[i] = '0;
+end
+
+always_ff @(posedge ahb_clk) begin
+    if(hofs_wen && busif.addr[10:2] < VGA_HEIGHT) hofs_ram[busif.addr[10:2]] <= busif.wdata[9:0];
+    hofs_q <= hofs_ram[req_line];
+end
+
+// Line buffer write side, one pixel per fetched SRAM word
+always_ff @(posedge ahb_clk) begin
+    if(rd_pend) line_buf[rd_buf ? VGA_WIDTH + rd_x : rd_x] <= sram_dq;
+end
+
+// Line buffer read side, registered with the sync signals. The buffer
+// holds one image row, each entry repeated over 1 << scan_scale pixels.
+// scan_* only change while line 0 is fetched, in vertical blanking.
+assign scan_dx = next_vga_x - scan_pos[9:0];
+assign scan_dy = next_vga_y - scan_pos[25:16];
+assign scan_on = next_vga_x >= scan_pos[9:0] && (scan_dx >> scan_scale) < scan_size[9:0] &&
+                 next_vga_y >= scan_pos[25:16] && (scan_dy >> scan_scale) < scan_size[25:16];
+
+always_ff @(posedge vga_clk) begin
+    if(next_vga_x < VGA_WIDTH) begin
+        if(scan_on) pixel <= line_buf[next_vga_y[0] ? VGA_WIDTH + (scan_dx >> scan_scale) : (scan_dx >> scan_scale)];
+        else pixel <= '0;
+    end
+end
+
+// =====================================================
+// Text Overlay
+// =====================================================
+// Cells and palette are written from the bus. The cell RAM is read by the
+// pixel clock two pixels ahead (wrapping into the next line), the glyph
+// ROM one clock later, so the overlay colour lands in the same clock as
+// the line buffer pixel and the sync signals keep their timing. Overlay
+// pixels of the TXT_KEY colour leave the image visible.
+initial begin
+    for(int i = 0; i < TXT_CELLS; i++) txt_ram[i] = '0;
+    txt_pal = '{16'hF81F, 16'h0000, 16'h0015, 16'h0540, 16'h0555, 16'hA800, 16'hA815, 16'hAAA0,
+                16'h5AAB, 16'h52BF, 16'h57EA, 16'h57FF, 16'hFAAA, 16'hFABF, 16'hFFEA, 16'hFFFF};
+end
+
+always_ff @(posedge ahb_clk) begin
+    if(txt_wen && busif.addr[12:2] < TXT_CELLS) txt_ram[busif.addr[12:2]] <= busif.wdata[15:0];
+    if(pal_wen) txt_pal[busif.addr[5:2]] <= busif.wdata[15:0];
+end
+
+always_comb begin
+    if(next_vga_x >= VGA_HTOTAL - 2) begin
+        txt_x = next_vga_x - 10'(VGA_HTOTAL - 2);
+        txt_y = (next_vga_y == VGA_VTOTAL - 1) ? '0 : next_vga_y + 1'b1;
+    end else begin
+        txt_x = next_vga_x + 2'd2;
+        txt_y = next_vga_y;
+    end
+end
+
+vga_font FONT (
+    .clk(vga_clk),
+    .code(txt_cell[6:0]),
+    .row(txt_row),
+    .bits(txt_bits)
+);
+
+always_ff @(posedge vga_clk) begin
+    // Cell of the pixel two ahead
+    txt_cell <= txt_ram[txt_y[9:4] * TXT_COLS + txt_x[9:4]];
+    txt_row <= txt_y[3:1];
+    txt_col <= txt_x[3:1];
+    txt_in <= txt_x < VGA_WIDTH && txt_y < VGA_HEIGHT;
+    // Glyph row of the pixel one ahead (txt_bits)
+    txt_attr <= txt_cell[15:8];
+    txt_col_q <= txt_col;
+    txt_in_q <= txt_in;
+    // Colour of the pixel itself, registered with pixel
+    txt_px <= txt_color;
+    txt_show <= txt_en && txt_in_q && txt_color != txt_key;
+end
+
+assign txt_color = txt_bits[3'd7 - txt_col_q] ? txt_pal[txt_attr[3:0]] : txt_pal[txt_attr[7:4]];
 
 // =====================================================
 // SRAM Control
 // =====================================================
+// The line fetch owns the SRAM until the next line is buffered (640 reads
+// per 800-pixel line, so ahb_clk must run at 25 MHz or more); queued CPU
+// writes drain in the cycles left over and through vertical blanking.
+// A requested page flip is taken when line 0 is fetched and no write is
+// still queued, so a frame never shows a half-written page; the view
+// registers are taken with it. A scaled view only fetches the image row
+// under each line, VIEW_SIZE pixels, and lines outside it fetch nothing.
+// SCROLL and the line's HOFS entry pick the row and the first column;
+// the fetch wraps to the row start at the view width.
+// The blitter gets whatever is left.
+assign sram_dq = (!sram_we_n) ? sram_wdat : 16'bz;
+
 always_comb begin
     next_sram_wdat = '0;
-    next_sram_addr = raddr;
+    next_sram_addr = fetch_addr;
     next_sram_ce_n = 1'b0;
-    next_sram_oe_n = 1'b0;
+    next_sram_oe_n = 1'b1;
     next_sram_we_n = 1'b1;
     next_sram_ub_n = 1'b0;
     next_sram_lb_n = 1'b0;
-    
-    if(busif.wen) begin
-        next_sram_wdat = busif.wdata;
-        next_sram_addr = busif.addr >> 2;
-        next_sram_ce_n = 1'b0;
-        next_sram_oe_n = 1'b1;
+
+    next_fetch_busy = fetch_busy;
+    next_fetch_buf = fetch_buf;
+    next_fetch_x = fetch_x;
+    next_fetch_addr = fetch_addr;
+    next_rd_pend = 1'b0;
+    next_rd_ptr = rd_ptr;
+    next_drain_hi = drain_hi;
+    next_front_page = front_page;
+    next_scan_pos = scan_pos;
+    next_scan_size = scan_size;
+    next_scan_scale = scan_scale;
+    next_scan_scroll = scan_scroll;
+    next_fetch_col_at = fetch_col_at;
+    next_fetch_base = fetch_base;
+    flip_take = 1'b0;
+    fetch_dy = '0;
+    fetch_row = '0;
+    fetch_col = '0;
+    next_blt_rd_src = 1'b0;
+    next_blt_rd_dst = 1'b0;
+    blt_grant = 1'b0;
+
+    if(req_sync[2] != req_sync[1]) begin
+        if(req_line == 0 && wfifo_empty && flip_req) begin
+            flip_take = 1'b1;
+            next_front_page = front_req;
+            next_scan_pos = view_pos;
+            next_scan_size = view_size;
+            next_scan_scale = view_scale;
+        end
+        if(req_line == 0) next_scan_scroll = scroll;
+        fetch_dy = req_line - next_scan_pos[25:16];
+        fetch_row = (fetch_dy >> next_scan_scale) + next_scan_scroll[25:16];
+        if(fetch_row >= next_scan_size[25:16]) fetch_row = fetch_row - next_scan_size[25:16];
+        fetch_col = {2'b0, next_scan_scroll[9:0]} + {{2{hofs_q[9]}}, hofs_q};
+        if(fetch_col[11]) fetch_col = fetch_col + next_scan_size[9:0];
+        else if(fetch_col >= next_scan_size[9:0]) fetch_col = fetch_col - next_scan_size[9:0];
+        next_fetch_busy = req_line >= next_scan_pos[25:16] && (fetch_dy >> next_scan_scale) < next_scan_size[25:16] &&
+                          next_scan_size[9:0] != 0;
+        next_fetch_buf = req_line[0];
+        next_fetch_x = '0;
+        next_fetch_col_at = fetch_col[9:0];
+        next_fetch_base = next_front_page * PAGE_WORDS + fetch_row[9:0] * VGA_WIDTH;
+        next_fetch_addr = next_fetch_base + fetch_col[9:0];
+    end
+    else if(fetch_busy) begin
+        next_sram_oe_n = 1'b0;
+        next_rd_pend = 1'b1;
+        next_fetch_x = fetch_x + 1'b1;
+        if(fetch_col_at == scan_size[9:0] - 1'b1) begin
+            next_fetch_col_at = '0;
+            next_fetch_addr = fetch_base;
+        end else begin
+            next_fetch_col_at = fetch_col_at + 1'b1;
+            next_fetch_addr = fetch_addr + 1'b1;
+        end
+        if(fetch_x == scan_size[9:0] - 1'b1) next_fetch_busy = 1'b0;
+    end
+    else if(!wfifo_empty) begin
+        // One 16-bit SRAM write per enabled half, low pixel first
         next_sram_we_n = 1'b0;
-        next_sram_ub_n = 1'b0;
-        next_sram_lb_n = 1'b0;
+        if(!drain_hi && |wr_head.strobe[1:0]) begin
+            next_sram_wdat = wr_head.data[15:0];
+            next_sram_addr = wr_head.addr;
+            next_sram_ub_n = !wr_head.strobe[1];
+            next_sram_lb_n = !wr_head.strobe[0];
+            if(|wr_head.strobe[3:2]) next_drain_hi = 1'b1;
+            else next_rd_ptr = rd_ptr + 1'b1;
+        end
+        else begin
+            next_sram_wdat = wr_head.data[31:16];
+            next_sram_addr = wr_head.addr | 20'd1;
+            next_sram_we_n = !(|wr_head.strobe[3:2]);
+            next_sram_ub_n = !wr_head.strobe[3];
+            next_sram_lb_n = !wr_head.strobe[2];
+            next_drain_hi = 1'b0;
+            next_rd_ptr = rd_ptr + 1'b1;
+        end
+    end
+    else if(blt_state == BLT_RSRC || blt_state == BLT_RDST || blt_state == BLT_WR) begin
+        blt_grant = 1'b1;
+        if(blt_state == BLT_WR) begin
+            next_sram_wdat = blt_result;
+            next_sram_addr = blt_dcur;
+            next_sram_we_n = 1'b0;
+        end else begin
+            next_sram_addr = (blt_state == BLT_RSRC) ? blt_scur : blt_dcur;
+            next_sram_oe_n = 1'b0;
+            next_blt_rd_src = (blt_state == BLT_RSRC);
+            next_blt_rd_dst = (blt_state == BLT_RDST);
+        end
     end
 end
 
@@ -279,6 +1006,22 @@ always_ff @(posedge ahb_clk, negedge n_rst) begin
         sram_ub_n <= 1'b1;
         sram_lb_n <= 1'b1;
         sram_wdat <= '0;
+        fetch_busy <= 1'b0;
+        fetch_buf <= 1'b0;
+        fetch_x <= '0;
+        fetch_addr <= '0;
+        fetch_col_at <= '0;
+        fetch_base <= '0;
+        rd_pend <= 1'b0;
+        rd_buf <= 1'b0;
+        rd_x <= '0;
+        rd_ptr <= '0;
+        drain_hi <= 1'b0;
+        front_page <= '0;
+        scan_pos <= '0;
+        scan_size <= {10'(VGA_HEIGHT), 6'b0, 10'(VGA_WIDTH)};
+        scan_scale <= '0;
+        scan_scroll <= '0;
     end else begin
         sram_addr <= next_sram_addr;
         sram_ce_n <= next_sram_ce_n;
@@ -287,23 +1030,67 @@ always_ff @(posedge ahb_clk, negedge n_rst) begin
         sram_ub_n <= next_sram_ub_n;
         sram_lb_n <= next_sram_lb_n;
         sram_wdat <= next_sram_wdat;
+        fetch_busy <= next_fetch_busy;
+        fetch_buf <= next_fetch_buf;
+        fetch_x <= next_fetch_x;
+        fetch_addr <= next_fetch_addr;
+        fetch_col_at <= next_fetch_col_at;
+        fetch_base <= next_fetch_base;
+        rd_pend <= next_rd_pend;
+        rd_buf <= fetch_buf;
+        rd_x <= fetch_x;
+        rd_ptr <= next_rd_ptr;
+        drain_hi <= next_drain_hi;
+        front_page <= next_front_page;
+        scan_pos <= next_scan_pos;
+        scan_size <= next_scan_size;
+        scan_scale <= next_scan_scale;
+        scan_scroll <= next_scan_scroll;
     end
 end
 
 // =====================================================
 // RGB Output Logic
 // =====================================================
-// Color (RGB 565)
+// The LUTs are written from the bus and read by the pixel clock. They
+// are small enough for registers, so the read is combinational and
+// the output keeps its timing against the sync signals.
+initial begin
+    for(int i = 0; i < 32; i++) begin
+        lut_r[i] = {i[4:0], i[4:2]};
+        lut_b[i] = {i[4:0], i[4:2]};
+    end
+    for(int i = 0; i < 64; i++) lut_g[i] = {i[5:0], i[5:4]};
+end
+
+always_ff @(posedge ahb_clk) begin
+    if(lut_wen) begin
+        case(busif.addr[9:8])
+            2'd0: if(!busif.addr[7]) lut_r[busif.addr[6:2]] <= busif.wdata[7:0];
+            2'd1: lut_g[busif.addr[7:2]] <= busif.wdata[7:0];
+            2'd2: if(!busif.addr[7]) lut_b[busif.addr[6:2]] <= busif.wdata[7:0];
+            default: ;
+        endcase
+    end
+end
+
+// Color (RGB 565). The overlay goes through the LUTs as well, so a fade
+// or colour correction covers the whole screen.
+assign out_px = txt_show ? txt_px : pixel;
+
 always_comb begin
     vga_r = 8'b0;
     vga_g = 8'b0;
     vga_b = 8'b0;
+    out_r = lut_r[out_px[15:11]] * bright;
+    out_g = lut_g[out_px[10:5]] * bright;
+    out_b = lut_b[out_px[4:0]] * bright;
 
-    if(!sram_oe_n) begin
-        vga_r = {sram_dq[15:11], 3'b0};
-        vga_g = {sram_dq[10:5], 2'b0};
-        vga_b = {sram_dq[4:0], 3'b0};
+    if(vga_blank_n) begin
+        vga_r = out_r[15:8];
+        vga_g = out_g[15:8];
+        vga_b = out_b[15:8];
     end
 end
 
-endmodule
\ No newline at end of file
+endmodule
@@ -0,0 +1,146 @@
+// Generated by VGA/gen_font.py, do not edit.
+// Glyph ROM of the text overlay: 128 codes of 8x8 cells, bit 7 is the
+// leftmost pixel. Codes below 0x20 are blank.
+module vga_font (
+    input logic clk,
+    input logic [6:0] code,
+    input logic [2:0] row,
+    output logic [7:0] bits     // registered, one clock after code and row
+);
+
+localparam logic [7:0] FONT [1024] = '{
+    8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00,  // 00 --
+    8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00,  // 01 --
+    8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00,  // 02 --
+    8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00,  // 03 --
+    8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00,  // 04 --
+    8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00,  // 05 --
+    8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00,  // 06 --
+    8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00,  // 07 --
+    8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00,  // 08 --
+    8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00,  // 09 --
+    8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00,  // 0A --
+    8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00,  // 0B --
+    8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00,  // 0C --
+    8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00,  // 0D --
+    8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00,  // 0E --
+    8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00,  // 0F --
+    8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00,  // 10 --
+    8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00,  // 11 --
+    8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00,  // 12 --
+    8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00,  // 13 --
+    8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00,  // 14 --
+    8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00,  // 15 --
+    8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00,  // 16 --
+    8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00,  // 17 --
+    8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00,  // 18 --
+    8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00,  // 19 --
+    8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00,  // 1A --
+    8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00,  // 1B --
+    8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00,  // 1C --
+    8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00,  // 1D --
+    8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00,  // 1E --
+    8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00,  // 1F --
+    8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00,  // 20  
+    8'h10, 8'h10, 8'h10, 8'h10, 8'h10, 8'h00, 8'h10, 8'h00,  // 21 !
+    8'h28, 8'h28, 8'h28, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00,  // 22 "
+    8'h28, 8'h28, 8'h7C, 8'h28, 8'h7C, 8'h28, 8'h28, 8'h00,  // 23 #
+    8'h10, 8'h3C, 8'h50, 8'h38, 8'h14, 8'h78, 8'h10, 8'h00,  // 24 $
+    8'h60, 8'h64, 8'h08, 8'h10, 8'h20, 8'h4C, 8'h0C, 8'h00,  // 25 %
+    8'h30, 8'h48, 8'h50, 8'h20, 8'h54, 8'h48, 8'h34, 8'h00,  // 26 &
+    8'h30, 8'h10, 8'h20, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00,  // 27 '
+    8'h08, 8'h10, 8'h20, 8'h20, 8'h20, 8'h10, 8'h08, 8'h00,  // 28 (
+    8'h20, 8'h10, 8'h08, 8'h08, 8'h08, 8'h10, 8'h20, 8'h00,  // 29 )
+    8'h00, 8'h10, 8'h54, 8'h38, 8'h54, 8'h10, 8'h00, 8'h00,  // 2A *
+    8'h00, 8'h10, 8'h10, 8'h7C, 8'h10, 8'h10, 8'h00, 8'h00,  // 2B +
+    8'h00, 8'h00, 8'h00, 8'h00, 8'h30, 8'h10, 8'h20, 8'h00,  // 2C ,
+    8'h00, 8'h00, 8'h00, 8'h7C, 8'h00, 8'h00, 8'h00, 8'h00,  // 2D -
+    8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h30, 8'h30, 8'h00,  // 2E .
+    8'h00, 8'h04, 8'h08, 8'h10, 8'h20, 8'h40, 8'h00, 8'h00,  // 2F /
+    8'h38, 8'h44, 8'h4C, 8'h54, 8'h64, 8'h44, 8'h38, 8'h00,  // 30 0
+    8'h10, 8'h30, 8'h10, 8'h10, 8'h10, 8'h10, 8'h38, 8'h00,  // 31 1
+    8'h38, 8'h44, 8'h04, 8'h08, 8'h10, 8'h20, 8'h7C, 8'h00,  // 32 2
+    8'h7C, 8'h08, 8'h10, 8'h08, 8'h04, 8'h44, 8'h38, 8'h00,  // 33 3
+    8'h08, 8'h18, 8'h28, 8'h48, 8'h7C, 8'h08, 8'h08, 8'h00,  // 34 4
+    8'h7C, 8'h40, 8'h78, 8'h04, 8'h04, 8'h44, 8'h38, 8'h00,  // 35 5
+    8'h18, 8'h20, 8'h40, 8'h78, 8'h44, 8'h44, 8'h38, 8'h00,  // 36 6
+    8'h7C, 8'h04, 8'h08, 8'h10, 8'h20, 8'h20, 8'h20, 8'h00,  // 37 7
+    8'h38, 8'h44, 8'h44, 8'h38, 8'h44, 8'h44, 8'h38, 8'h00,  // 38 8
+    8'h38, 8'h44, 8'h44, 8'h3C, 8'h04, 8'h08, 8'h30, 8'h00,  // 39 9
+    8'h00, 8'h30, 8'h30, 8'h00, 8'h30, 8'h30, 8'h00, 8'h00,  // 3A :
+    8'h00, 8'h30, 8'h30, 8'h00, 8'h30, 8'h10, 8'h20, 8'h00,  // 3B ;
+    8'h08, 8'h10, 8'h20, 8'h40, 8'h20, 8'h10, 8'h08, 8'h00,  // 3C <
+    8'h00, 8'h00, 8'h7C, 8'h00, 8'h7C, 8'h00, 8'h00, 8'h00,  // 3D =
+    8'h20, 8'h10, 8'h08, 8'h04, 8'h08, 8'h10, 8'h20, 8'h00,  // 3E >
+    8'h38, 8'h44, 8'h04, 8'h08, 8'h10, 8'h00, 8'h10, 8'h00,  // 3F ?
+    8'h38, 8'h44, 8'h04, 8'h34, 8'h54, 8'h54, 8'h38, 8'h00,  // 40 @
+    8'h38, 8'h44, 8'h44, 8'h44, 8'h7C, 8'h44, 8'h44, 8'h00,  // 41 A
+    8'h78, 8'h44, 8'h44, 8'h78, 8'h44, 8'h44, 8'h78, 8'h00,  // 42 B
+    8'h38, 8'h44, 8'h40, 8'h40, 8'h40, 8'h44, 8'h38, 8'h00,  // 43 C
+    8'h70, 8'h48, 8'h44, 8'h44, 8'h44, 8'h48, 8'h70, 8'h00,  // 44 D
+    8'h7C, 8'h40, 8'h40, 8'h78, 8'h40, 8'h40, 8'h7C, 8'h00,  // 45 E
+    8'h7C, 8'h40, 8'h40, 8'h78, 8'h40, 8'h40, 8'h40, 8'h00,  // 46 F
+    8'h38, 8'h44, 8'h40, 8'h5C, 8'h44, 8'h44, 8'h3C, 8'h00,  // 47 G
+    8'h44, 8'h44, 8'h44, 8'h7C, 8'h44, 8'h44, 8'h44, 8'h00,  // 48 H
+    8'h38, 8'h10, 8'h10, 8'h10, 8'h10, 8'h10, 8'h38, 8'h00,  // 49 I
+    8'h1C, 8'h08, 8'h08, 8'h08, 8'h08, 8'h48, 8'h30, 8'h00,  // 4A J
+    8'h44, 8'h48, 8'h50, 8'h60, 8'h50, 8'h48, 8'h44, 8'h00,  // 4B K
+    8'h40, 8'h40, 8'h40, 8'h40, 8'h40, 8'h40, 8'h7C, 8'h00,  // 4C L
+    8'h44, 8'h6C, 8'h54, 8'h54, 8'h44, 8'h44, 8'h44, 8'h00,  // 4D M
+    8'h44, 8'h44, 8'h64, 8'h54, 8'h4C, 8'h44, 8'h44, 8'h00,  // 4E N
+    8'h38, 8'h44, 8'h44, 8'h44, 8'h44, 8'h44, 8'h38, 8'h00,  // 4F O
+    8'h78, 8'h44, 8'h44, 8'h78, 8'h40, 8'h40, 8'h40, 8'h00,  // 50 P
+    8'h38, 8'h44, 8'h44, 8'h44, 8'h54, 8'h48, 8'h34, 8'h00,  // 51 Q
+    8'h78, 8'h44, 8'h44, 8'h78, 8'h50, 8'h48, 8'h44, 8'h00,  // 52 R
+    8'h3C, 8'h40, 8'h40, 8'h38, 8'h04, 8'h04, 8'h78, 8'h00,  // 53 S
+    8'h7C, 8'h10, 8'h10, 8'h10, 8'h10, 8'h10, 8'h10, 8'h00,  // 54 T
+    8'h44, 8'h44, 8'h44, 8'h44, 8'h44, 8'h44, 8'h38, 8'h00,  // 55 U
+    8'h44, 8'h44, 8'h44, 8'h44, 8'h44, 8'h28, 8'h10, 8'h00,  // 56 V
+    8'h44, 8'h44, 8'h44, 8'h54, 8'h54, 8'h54, 8'h28, 8'h00,  // 57 W
+    8'h44, 8'h44, 8'h28, 8'h10, 8'h28, 8'h44, 8'h44, 8'h00,  // 58 X
+    8'h44, 8'h44, 8'h44, 8'h28, 8'h10, 8'h10, 8'h10, 8'h00,  // 59 Y
+    8'h7C, 8'h04, 8'h08, 8'h10, 8'h20, 8'h40, 8'h7C, 8'h00,  // 5A Z
+    8'h38, 8'h20, 8'h20, 8'h20, 8'h20, 8'h20, 8'h38, 8'h00,  // 5B [
+    8'h00, 8'h40, 8'h20, 8'h10, 8'h08, 8'h04, 8'h00, 8'h00,  // 5C \
+    8'h38, 8'h08, 8'h08, 8'h08, 8'h08, 8'h08, 8'h38, 8'h00,  // 5D ]
+    8'h10, 8'h28, 8'h44, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00,  // 5E ^
+    8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00, 8'h7C, 8'h00,  // 5F _
+    8'h20, 8'h10, 8'h08, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00,  // 60 `
+    8'h00, 8'h00, 8'h38, 8'h04, 8'h3C, 8'h44, 8'h3C, 8'h00,  // 61 a
+    8'h40, 8'h40, 8'h58, 8'h64, 8'h44, 8'h44, 8'h78, 8'h00,  // 62 b
+    8'h00, 8'h00, 8'h38, 8'h40, 8'h40, 8'h44, 8'h38, 8'h00,  // 63 c
+    8'h04, 8'h04, 8'h34, 8'h4C, 8'h44, 8'h44, 8'h3C, 8'h00,  // 64 d
+    8'h00, 8'h00, 8'h38, 8'h44, 8'h7C, 8'h40, 8'h38, 8'h00,  // 65 e
+    8'h18, 8'h24, 8'h20, 8'h70, 8'h20, 8'h20, 8'h20, 8'h00,  // 66 f
+    8'h00, 8'h3C, 8'h44, 8'h44, 8'h3C, 8'h04, 8'h38, 8'h00,  // 67 g
+    8'h40, 8'h40, 8'h58, 8'h64, 8'h44, 8'h44, 8'h44, 8'h00,  // 68 h
+    8'h10, 8'h00, 8'h30, 8'h10, 8'h10, 8'h10, 8'h38, 8'h00,  // 69 i
+    8'h08, 8'h00, 8'h18, 8'h08, 8'h08, 8'h48, 8'h30, 8'h00,  // 6A j
+    8'h40, 8'h40, 8'h48, 8'h50, 8'h60, 8'h50, 8'h48, 8'h00,  // 6B k
+    8'h30, 8'h10, 8'h10, 8'h10, 8'h10, 8'h10, 8'h38, 8'h00,  // 6C l
+    8'h00, 8'h00, 8'h68, 8'h54, 8'h54, 8'h44, 8'h44, 8'h00,  // 6D m
+    8'h00, 8'h00, 8'h58, 8'h64, 8'h44, 8'h44, 8'h44, 8'h00,  // 6E n
+    8'h00, 8'h00, 8'h38, 8'h44, 8'h44, 8'h44, 8'h38, 8'h00,  // 6F o
+    8'h00, 8'h00, 8'h78, 8'h44, 8'h78, 8'h40, 8'h40, 8'h00,  // 70 p
+    8'h00, 8'h00, 8'h34, 8'h4C, 8'h3C, 8'h04, 8'h04, 8'h00,  // 71 q
+    8'h00, 8'h00, 8'h58, 8'h64, 8'h40, 8'h40, 8'h40, 8'h00,  // 72 r
+    8'h00, 8'h00, 8'h38, 8'h40, 8'h38, 8'h04, 8'h78, 8'h00,  // 73 s
+    8'h20, 8'h20, 8'h70, 8'h20, 8'h20, 8'h24, 8'h18, 8'h00,  // 74 t
+    8'h00, 8'h00, 8'h44, 8'h44, 8'h44, 8'h4C, 8'h34, 8'h00,  // 75 u
+    8'h00, 8'h00, 8'h44, 8'h44, 8'h44, 8'h28, 8'h10, 8'h00,  // 76 v
+    8'h00, 8'h00, 8'h44, 8'h44, 8'h54, 8'h54, 8'h28, 8'h00,  // 77 w
+    8'h00, 8'h00, 8'h44, 8'h28, 8'h10, 8'h28, 8'h44, 8'h00,  // 78 x
+    8'h00, 8'h00, 8'h44, 8'h44, 8'h3C, 8'h04, 8'h38, 8'h00,  // 79 y
+    8'h00, 8'h00, 8'h7C, 8'h08, 8'h10, 8'h20, 8'h7C, 8'h00,  // 7A z
+    8'h08, 8'h10, 8'h10, 8'h20, 8'h10, 8'h10, 8'h08, 8'h00,  // 7B {
+    8'h10, 8'h10, 8'h10, 8'h10, 8'h10, 8'h10, 8'h10, 8'h00,  // 7C |
+    8'h20, 8'h10, 8'h10, 8'h08, 8'h10, 8'h10, 8'h20, 8'h00,  // 7D }
+    8'h20, 8'h54, 8'h08, 8'h00, 8'h00, 8'h00, 8'h00, 8'h00,  // 7E ~
+    8'h7C, 8'h7C, 8'h7C, 8'h7C, 8'h7C, 8'h7C, 8'h7C, 8'h00  // 7F --
+};
+
+always_ff @(posedge clk) begin
+    bits <= FONT[{code, row}];
+end
+
+endmodule
@@ -4,14 +4,25 @@
 #include <stdlib.h>
 #include "FatFs/source/pal.h"
 #include "FatFs/source/ff.h"
+#include "FatFs/source/diskio.h"
+#include "rgb565.h"
+#include "scale.h"
 
-static volatile uint32_t * const vga_fb = (volatile uint32_t *)0xD0000000;
+static volatile uint32_t * const vga_fb = (volatile uint32_t *)(VGA_BASE + VGA_PIXEL_OFFSET);
+static volatile uint32_t * const vga_fb_packed = (volatile uint32_t *)(VGA_BASE + VGA_PACKED_OFFSET);  // two pixels per word
+static volatile uint32_t * const vga_stream = (volatile uint32_t *)(VGA_BASE + VGA_STREAM_OFFSET);  // window order
+static volatile uint32_t * const vga_lut = (volatile uint32_t *)(VGA_BASE + VGA_LUT_OFFSET);  // VGA_LUT_R/G/B
+static volatile uint32_t * const vga_hofs = (volatile uint32_t *)(VGA_BASE + VGA_HOFS_OFFSET);  // per screen line
+static volatile uint32_t * const vga_txt = (volatile uint32_t *)(VGA_BASE + VGA_TXT_OFFSET);  // overlay cells, row-major
+static VGARegBlk *const vga = (VGARegBlk *)(VGA_BASE + VGA_REG_OFFSET);
 
 // ======================================================================
 // Define constants
 // ======================================================================
 // UART
 #define BAUD_CYCLES 2604
+#define UART_POLL_TICKS (10 * BAUD_CYCLES)  // one character, the RX FIFO holds 3
+#define UART_RING   4096            // received bytes waiting for uart_rx(), power of 2
 #define ACK         0
 #define DONE        1
 #define BAD         2
@@ -23,14 +34,82 @@ static volatile uint32_t * const vga_fb = (volatile uint32_t *)0xD0000000;
 #define TYPE_DUMMY  0x7F
 #define TYPE_META   0x01
 #define TYPE_DATA   0x02
-#define MAX_FRAME   (10 * 1024)
+#define TYPE_DELTA  0x03            // starts a tile patch of an image on the card
+#define MAX_CHUNK   1024            // DATA payload, a META or DELTA asking for more gets BAD
+#define MAX_FRAME   (11 + MAX_CHUNK)    // DATA header and payload, META with a full name is less
+#if UART_RING < 2 * MAX_FRAME + 2
+#error UART_RING must hold a DATA frame with every byte escaped
+#endif
 #define MEM_SIZE    (10 * 1024)
 // FatFs
 #define SEC_SIZE    512
+#define FILE_SLOTS  2
+// Catalog
+#define CATALOG_FILE    "catalog.bin"
+#define CATALOG_TMP     "catalog.tmp"
+#define CATALOG_MAGIC   0x4C544143      // "CATL"
+#define CATALOG_VERSION 5
+#define MAX_PHOTOS      32
 // Image (Color)
 #define BMP_HEADER  54
 #define IMG_WIDTH   640
 #define IMG_HEIGHT  480
+// Framebuffer-native store: top-down RGB565 rows, no padding, no header
+#define FB_ROW      (IMG_WIDTH * 2)
+#define KEEP_BMP    0               // 1: also store the received BMP as sent
+#define RESIZE_BMP  0               // 1: resize other sizes to fit while receiving (scale.c)
+#define LAYOUT_BMP  0x01
+#define LAYOUT_FB   0x02
+#define LAYOUT_RLE  0x04
+// Run-length store (image%d.rle): header {RLE_MAGIC, width, height}, then
+// 16-bit tokens. RLE_RUN | n is followed by one pixel repeated n times,
+// n alone by n literal pixels. Bands of two rows are coded bottom band
+// first as they arrive, top-down inside a band, runs never cross bands.
+#define STORE_RLE   0               // 1: also encode received images, kept when small enough, and show them
+#define RLE_MAGIC   0x35363552      // "R565"
+#define RLE_HEADER  8
+#define RLE_RUN     0x8000
+#define RLE_MAX     0x7FFF
+#define RLE_MIN_RUN 3               // shorter repeats cost less as literals
+#define RLE_BLIT_MIN 16             // runs this long are painted by the blitter
+#define RLE_KEEP    75              // kept instead of the .fb copy below this % of its size
+// Dirty rectangles: META version 2 may list where an image differs from
+// the one sent before it, {base_crc, n, n * {x, y, w, h}} after the name
+#define DIRTY_RECTS 0               // 1: repaint only those rectangles when the base is on screen
+#define DIRTY_MAX   4               // rectangles kept per image, the sender merges down to it
+// Tile patches: DATA frames after TYPE_DELTA carry records of a 16-bit
+// tile index, row-major on the 640x480 grid, then its 16 RGB565 rows top-down
+#define TILE_DELTA  0               // 1: accept tile patches, else TYPE_DELTA gets BAD
+#define TILE        16
+#define TILE_COLS   (IMG_WIDTH / TILE)
+#define TILE_ROW    (TILE * 2)      // bytes of one tile row
+#define TILE_REC    (2 + TILE * TILE_ROW)
+#define DELTA_INPLACE 0x01          // patch the base itself, else a copy in the next slot
+// Slideshow
+#define SLIDE_MS    5000            // dwell per slide
+// Timer service
+#define MTIME_HZ    50000000        // CLINT mtime rate, the core clock
+#define TIMER_MS(ms) ((uint32_t)(ms) * (MTIME_HZ / 1000))
+#define TIMER_SLOTS 4
+// Display output
+#define GAMMA_Q     4               // output gamma in quarters, 4 is linear
+// Receive preview
+#define VGA_RX_PAGE 2               // live preview of the image being received
+// Wave effect
+#define WAVE_FX     0               // 1: ripple the slide on screen through the line offsets, unsimulated
+#define WAVE_AMP    6               // screen pixels either way
+#define WAVE_SPEED  1               // wave_sin steps per frame
+// Text overlay
+#define TXT_STATUS_ROW (VGA_TXT_ROWS - 1)   // receive progress and errors
+#define TXT_FG      15              // white on the reset palette
+#define TXT_BG      1               // black, entry 0 is transparent
+// Interrupts
+#define MSTATUS_MIE (1<<3)
+#define MIE_MTIE    (1<<7)
+#define MIE_MEIE    (1<<11)
+#define MCAUSE_IRQ  (1u<<31)
+#define MCAUSE_MTI  7
+#define MCAUSE_MEI  11
 
 // ======================================================================
 // Define structures
@@ -46,6 +125,63 @@ typedef struct {
     char     fname[256];
 } transfer_info_t;
 
+typedef struct {
+    FIL      fil;
+    char     name[32];
+    uint8_t  open;         // fil is open on name
+    uint8_t  busy;         // handed out by file_get()
+    uint32_t stamp;        // last use, for LRU reuse
+} file_slot_t;
+
+// Screen rectangle, top-down image coordinates
+typedef struct {
+    uint16_t x, y, w, h;
+} vga_rect_t;
+
+// One received image, as recorded in CATALOG_FILE
+typedef struct {
+    uint32_t layouts;      // LAYOUT_BMP, LAYOUT_FB and/or LAYOUT_RLE stored on the card
+    char     name[16];     // BMP file
+    uint32_t sclust;       // first cluster, detects a file replaced behind the catalog
+    uint32_t size;         // file size
+    uint32_t pixel_offset; // BMP pixel array offset
+    int32_t  width;
+    int32_t  height;       // as in the BMP header, negative for top-down
+    uint32_t bpp;          // BMP bits per pixel: 16 (RGB565), 24 or 32
+    uint32_t crc;          // CRC-32 of the BMP as received (0: unknown)
+    char     fb_name[16];  // framebuffer-native file
+    uint32_t fb_sclust;
+    uint32_t fb_size;
+    char     rle_name[16]; // run-length file
+    uint32_t rle_sclust;
+    uint32_t rle_size;
+    uint32_t base_crc;     // crc of the image rects[] are against (0: none)
+    uint32_t n_rects;
+    vga_rect_t rects[DIRTY_MAX];   // the only regions that differ from it
+} catalog_entry_t;
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint8_t  count;        // valid entries, image0..image(count-1)
+    uint8_t  next;         // entry the next received image goes to
+    uint32_t crc;          // CRC-32 of entries[0..count-1]
+} catalog_hdr_t;
+
+// Software deadline on the machine timer
+typedef struct {
+    uint64_t due;          // mtime of the next expiry
+    uint32_t period;       // reload in mtime ticks, 0 for one-shot
+    void   (*fn)(void);    // called from the interrupt, may be 0 (wake-up only)
+    uint8_t  active;
+} sw_timer_t;
+
+// How the scanout shows one page
+typedef struct {
+    uint32_t w, h;         // image size, stored top-left in the page
+    uint32_t scale;        // log2 of the zoom
+} vga_view_t;
+
 typedef enum { 
     ST_IDLE = 0, 
     ST_IN, 
@@ -76,11 +212,71 @@ static uint32_t          photo_offset = 0;
 static uint32_t          dummy_flag = 0;
 static uint32_t          image_done = 0;
 static FATFS             fs;
-static FIL               fil;
+static int               fs_mounted = 0;
+static file_slot_t       file_slots[FILE_SLOTS];
+static uint32_t          file_clock = 0;
+static FIL              *fil;            // BMP being received, 0 if not kept
+static FIL              *fb_fil;         // framebuffer-native file being received
+static FIL              *rle_fil;        // run-length file being received
 static int               file_opened = 0;
 static char              filename[32];
+static char              fb_filename[32];
+static char              rle_filename[32];
+static uint8_t           fb_rows[2 * FB_ROW] __attribute__((aligned(4))); // BMP row pair, stored top-down
+static uint8_t           rx_carry[4];    // 24/32 bpp pixel split across DATA frames
+static uint32_t          rx_scaled;      // the BMP is not 640x480 and goes through scale_pixel()
+static uint32_t          rx_zoomed;      // the BMP is kept as sent and zoomed by the scanout
+static FRESULT           rx_scale_res;   // first fb_fil error while scaling
+static uint32_t          fb_pairs;       // row pairs written to fb_fil
+static uint8_t           rle_buf[SEC_SIZE];
+static uint32_t          rle_bytes;
+static FRESULT           rle_res;        // first write error on rle_fil
 static uint8_t           write_buf[SEC_SIZE];
 static uint32_t          write_bytes = 0;
+static catalog_entry_t   catalog[MAX_PHOTOS];
+static uint32_t          photo_next = 0; // catalog entry for the next received image
+static uint32_t          rx_crc;         // running CRC-32 of the image being received
+static uint8_t           rx_header[BMP_HEADER];
+static uint32_t          disp_pos;       // bytes (BMP) or pixels (framebuffer layout) painted
+static uint32_t          disp_word;      // bytes of a stream word split across sectors
+static uint32_t          disp_x, disp_y; // run-length cursor, disp_y >= IMG_HEIGHT when done
+static uint32_t          rle_left;       // pixels left in the token being painted
+static uint32_t          rle_run;        // that token is a run
+static uint32_t          vga_back = 1;   // page painted while the other one is on screen
+static uint32_t          vga_shown;      // page on screen
+static vga_view_t        vga_views[VGA_PAGES] = {
+    { IMG_WIDTH, IMG_HEIGHT, 0 }, { IMG_WIDTH, IMG_HEIGHT, 0 }, { IMG_WIDTH, IMG_HEIGHT, 0 },
+};
+static uint32_t          rx_preview;     // rows of the image being received go to VGA_RX_PAGE
+static uint32_t          rx_shown;       // rows painted there
+static uint32_t          rx_preview_done;    // VGA_RX_PAGE holds the whole received image
+static uint32_t          rx_base_crc;    // dirty rectangles from META, for the catalog entry
+static uint32_t          rx_n_rects;
+static vga_rect_t        rx_rects[DIRTY_MAX];
+static uint32_t          vga_page_crc[VGA_PAGES];    // crc of the complete image in each page, 0 if none
+static uint32_t          rx_delta;       // the transfer patches tiles instead of sending a BMP
+static uint32_t          rx_delta_src;   // catalog entry patched, or copied when the slot differs
+static uint32_t          rx_delta_dst;
+static uint32_t          rx_delta_layout;    // LAYOUT_FB or LAYOUT_BMP, the file patched
+static uint32_t          rx_delta_base;  // file offset of pixel (0, 0)
+static int               rx_delta_up;    // rows stored bottom-up
+static uint32_t          rx_delta_crc;   // crc of the image once patched
+static uint32_t          rx_delta_live;  // the base is on screen, tiles are painted there too
+static FIL              *delta_fil;
+static uint32_t          rx_tile;        // tile of the record being received
+static uint32_t          rx_tile_pos;    // bytes of that record received
+static uint8_t           rx_tile_lo;     // low byte of a pixel split across frames
+static uint32_t          rx_percent;     // progress on the status line, above 100 before the first
+static uint8_t           uart_ring[UART_RING];
+static volatile uint32_t uart_head;      // written by uart_poll() only
+static volatile uint32_t uart_tail;      // written by uart_rx() only
+static volatile uint32_t uart_overruns;  // bytes uart_poll() found no room for
+static uint32_t          uart_overruns_seen;
+static void            (*vblank_hook)(uint32_t frame);
+static CLINTRegBlk *const clint = (CLINTRegBlk *)CLINT_BASE;
+static sw_timer_t        timers[TIMER_SLOTS];
+static volatile int      slide_timer = -1;
+static volatile int      slide_due;      // dwell of the slide on screen is over
 
 // ======================================================================
 // Declare functions
@@ -88,6 +284,7 @@ static uint32_t          write_bytes = 0;
 static inline uint16_t   rd16(const uint8_t *p);
 static inline uint32_t   rd32(const uint8_t *p);
 static void              uart_rx(void);
+static void              uart_poll(void);
 static void              split_byte_stream(uint8_t byte);
 static void              handle_frame(uint8_t *buf, uint32_t frame_num);
 static void              handle_meta(const uint8_t *buf, uint32_t frame_num);
@@ -97,10 +294,189 @@ static inline uint32_t   rd32(const uint8_t *p);
 static void              handle_frame(uint8_t *buf, uint32_t frame_num);
 static void              handle_meta (const uint8_t *buf, uint32_t frame_num);
 static void              handle_data (const uint8_t *buf, uint32_t frame_num);
-static void              display_rgb565_image (char filename[32]);
+static void              handle_delta(const uint8_t *buf, uint32_t frame_num);
+static FIL              *file_get(const char *name, BYTE mode, FRESULT *res);
+static void              file_put(FIL *f);
+static void              volume_reset(void);
+static void              file_forget(const char *name);
+static uint32_t          crc32_update(uint32_t crc, const uint8_t *p, uint32_t len);
+static int               catalog_load(const char *name);
+static void              catalog_save(void);
+static void              catalog_rescan(void);
+static int               catalog_probe(catalog_entry_t *e, uint32_t index);
+static int               rx_begin(void);
+static void              rx_abort(FRESULT res);
+static FRESULT           rx_write_bmp(const uint8_t *p, uint32_t len);
+static FRESULT           rx_transcode(const uint8_t *p, uint32_t len, uint32_t pos);
+static void              rx_convert(uint8_t *row, const uint8_t *p, uint32_t len, uint32_t col, uint32_t y, uint32_t bpp);
+static void              rx_scale(const uint8_t *p, uint32_t len, uint32_t col, uint32_t bpp);
+static FRESULT           rx_put_pair(uint32_t y);
+static uint16_t         *rx_row_begin(uint32_t y);
+static void              rx_row_end(uint32_t y);
+static void              rx_preview_rows(const uint32_t *px, uint32_t y, uint32_t w, uint32_t n);
+static int               rx_preview_take(void);
+static int               display_rgb565_image (uint32_t index);
+static int               display_rects(uint32_t index, const vga_rect_t *r, uint32_t n);
+static int               display_slide(uint32_t index);
+static uint32_t          image_rows(const catalog_entry_t *e, uint32_t *base, int *bottom_up);
+static void              image_drop(const catalog_entry_t *e);
+static FIL              *delta_copy(const char *src, const char *dst, FRESULT *res);
+static FRESULT           rx_patch(const uint8_t *p, uint32_t len);
+static void              rx_patch_end(void);
+static void              vga_flip(void);
+static void              vga_show(uint32_t page);
+static void              vga_view(uint32_t page, uint32_t w, uint32_t h, uint32_t scale);
+static uint32_t          vga_zoom(uint32_t w, uint32_t h);
+static void              vga_blit_fill(uint32_t page, uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint16_t color);
+static void              vga_blit_copy(uint32_t dst, uint32_t src, uint32_t w, uint32_t h);
+static void              vga_blit_wait(void);
+static uint32_t          vga_frame(void);
+static void              vga_wait_vblank(void);
+static void              vga_on_vblank(void (*hook)(uint32_t frame));
+static void              vga_scroll(int32_t x, int32_t y);
+static void              vga_line_offset(uint32_t y, int32_t dx);
+static void              vga_wave(uint32_t frame);
+static void              vga_gamma(uint32_t quarters);
+static void              vga_brightness(uint32_t level);
+static uint32_t          vga_text(uint32_t col, uint32_t row, const char *s, uint32_t fg, uint32_t bg);
+static void              vga_text_clear(void);
+static void              status_show(const char *s);
+static void              irq_init(void);
+static uint64_t          timer_now(void);
+static void              timer_arm(void);
+static int               timer_start(uint32_t ticks, uint32_t period, void (*fn)(void));
+static void              timer_stop(int id);
+static void              timer_isr(void);
+static void              cpu_idle(void);
+static void              slide_expired(void);
+static void              trap_handler(void) __attribute__((interrupt("machine"), aligned(4)));
+static UINT              display_sink(const BYTE *p, UINT len);
+static UINT              display_fb_sink(const BYTE *p, UINT len);
+static UINT              display_rle_sink(const BYTE *p, UINT len);
+static void              rle_step(uint32_t n);
+static void              rle_fill(uint16_t color, uint32_t n);
+static void              rle_word(uint16_t v);
+static uint32_t          rle_repeat(const uint16_t *px, uint32_t n);
+static void              rle_put(const uint16_t *px, uint32_t n);
 static void              search_next_image();
 static void              send_ack(int TYPE);
 
+// ======================================================================
+// Interrupts
+// The CLINT machine timer and external interrupts through the PLIC
+// (context 0)
+// ======================================================================
+static void irq_init(void) {
+    __asm__ volatile ("csrw mtvec, %0" :: "r"(trap_handler));
+    *PLIC_PRIORITY(PLIC_BASE, VGA_IRQ) = 1;
+    *PLIC_ENABLE(PLIC_BASE, VGA_IRQ, 0) |= 1u << (VGA_IRQ % 32);
+    *PLIC_PRIORITY_THRESHOLD(PLIC_BASE, 0) = 0;
+    timer_arm();
+    __asm__ volatile ("csrs mie, %0" :: "r"(MIE_MEIE | MIE_MTIE));
+    __asm__ volatile ("csrs mstatus, %0" :: "r"(MSTATUS_MIE));
+}
+
+static void trap_handler(void) {
+    uint32_t cause;
+
+    __asm__ volatile ("csrr %0, mcause" : "=r"(cause));
+    if (cause == (MCAUSE_IRQ | MCAUSE_MTI)) {
+        timer_isr();
+    } else if (cause == (MCAUSE_IRQ | MCAUSE_MEI)) {
+        uint32_t src = *PLIC_CLAIM_COMPLETE(PLIC_BASE, 0);
+
+        if (src == VGA_IRQ && (vga->vbl_ctrl & VGA_VBL_PENDING)) {
+            vga->vbl_ctrl = VGA_VBL_IRQ_EN | VGA_VBL_PENDING;
+            if (vblank_hook) vblank_hook(vga->frame);
+        }
+        if (src) *PLIC_CLAIM_COMPLETE(PLIC_BASE, 0) = src;
+    }
+}
+
+// Sleeps until the next interrupt. The UART has no interrupt line, so the
+// periodic uart_poll() timer bounds the sleep.
+static void cpu_idle(void) {
+    __asm__ volatile ("wfi");
+}
+
+// ======================================================================
+// Timer service
+// One-shot and periodic deadlines on the CLINT machine timer. mtimecmp
+// always holds the earliest active deadline.
+// ======================================================================
+// Read the 64-bit machine timer without tearing between halves
+static uint64_t timer_now(void) {
+    uint32_t hi, lo;
+    do {
+        hi = clint->mtime.h;
+        lo = clint->mtime.l;
+    } while (hi != clint->mtime.h);
+    return ((uint64_t)hi << 32) | lo;
+}
+
+static void timer_arm(void) {
+    uint64_t next = UINT64_MAX;
+
+    for (int i = 0; i < TIMER_SLOTS; i++) {
+        if (timers[i].active && timers[i].due < next) next = timers[i].due;
+    }
+    // High word first parked at the maximum, so no early match in between
+    clint->mtimecmp[0].h = 0xFFFFFFFF;
+    clint->mtimecmp[0].l = (uint32_t)next;
+    clint->mtimecmp[0].h = (uint32_t)(next >> 32);
+}
+
+// Calls fn ticks from now, then every period ticks if period is not 0.
+// Returns the timer id, -1 when every slot is in use.
+static int timer_start(uint32_t ticks, uint32_t period, void (*fn)(void)) {
+    int id = -1;
+
+    __asm__ volatile ("csrc mie, %0" :: "r"(MIE_MTIE));
+    for (int i = 0; i < TIMER_SLOTS; i++) {
+        if (!timers[i].active) {
+            timers[i].due = timer_now() + ticks;
+            timers[i].period = period;
+            timers[i].fn = fn;
+            timers[i].active = 1;
+            id = i;
+            break;
+        }
+    }
+    timer_arm();
+    __asm__ volatile ("csrs mie, %0" :: "r"(MIE_MTIE));
+    return id;
+}
+
+static void timer_stop(int id) {
+    if (id < 0 || id >= TIMER_SLOTS) return;
+    __asm__ volatile ("csrc mie, %0" :: "r"(MIE_MTIE));
+    timers[id].active = 0;
+    timer_arm();
+    __asm__ volatile ("csrs mie, %0" :: "r"(MIE_MTIE));
+}
+
+static void timer_isr(void) {
+    uint64_t now = timer_now();
+
+    for (int i = 0; i < TIMER_SLOTS; i++) {
+        sw_timer_t *t = &timers[i];
+        if (!t->active || t->due > now) continue;
+        if (t->period) {
+            t->due += t->period;
+            if (t->due <= now) t->due = now + t->period;    // missed periods are dropped
+        } else {
+            t->active = 0;
+        }
+        if (t->fn) t->fn();
+    }
+    timer_arm();
+}
+
+static void slide_expired(void) {
+    slide_timer = -1;
+    slide_due = 1;
+}
+
 // ======================================================================
 // Functions
 // ======================================================================
@@ -130,73 +506,1157 @@ static void send_ack(int TYPE) {
     }
 }
 
-static void display_rgb565_image(char *filename) {
+// ======================================================================
+// Volume service
+// The volume stays mounted and read handles stay open between slides,
+// so a slide change costs no remount and no directory lookup.
+// ======================================================================
+static void volume_reset(void) {
+    for (int i = 0; i < FILE_SLOTS; i++) {
+        file_slots[i].open = 0;
+        file_slots[i].busy = 0;
+    }
+    f_mount(0, "", 0);
+    fs_mounted = 0;
+}
+
+static FIL *file_get(const char *name, BYTE mode, FRESULT *res) {
+    file_slot_t *slot = 0;
+
+    if (!fs_mounted) {
+        *res = f_mount(&fs, "", 1);
+        if (*res) return 0;
+        fs_mounted = 1;
+    }
+
+    for (int i = 0; i < FILE_SLOTS; i++) {
+        file_slot_t *s = &file_slots[i];
+        if (!s->open || strcmp(s->name, name)) continue;
+        if (mode == FA_READ && !s->busy) {
+            // Reuse the open read handle
+            *res = f_lseek(&s->fil, 0);
+            if (*res) break;
+            s->busy = 1;
+            s->stamp = ++file_clock;
+            return &s->fil;
+        }
+        // A file about to be rewritten must not stay open elsewhere
+        if (s->busy) {
+            *res = FR_LOCKED;
+            return 0;
+        }
+    }
+    if (mode != FA_READ) file_forget(name);
+
+    // Take a closed slot, else the least recently used idle one
+    for (int i = 0; i < FILE_SLOTS; i++) {
+        file_slot_t *s = &file_slots[i];
+        if (s->busy) continue;
+        if (!slot || !s->open || (slot->open && s->stamp < slot->stamp)) slot = s;
+        if (!s->open) break;
+    }
+    if (!slot) {
+        *res = FR_TOO_MANY_OPEN_FILES;
+        return 0;
+    }
+    if (slot->open) {
+        f_close(&slot->fil);
+        slot->open = 0;
+    }
+
+    *res = f_open(&slot->fil, name, mode);
+    if (*res) {
+        if (*res == FR_DISK_ERR || *res == FR_NOT_READY) volume_reset();
+        return 0;
+    }
+    snprintf(slot->name, sizeof(slot->name), "%s", name);
+    slot->open = 1;
+    slot->busy = 1;
+    slot->stamp = ++file_clock;
+    return &slot->fil;
+}
+
+// Closes idle handles on name before it is rewritten, renamed or removed
+static void file_forget(const char *name) {
+    for (int i = 0; i < FILE_SLOTS; i++) {
+        file_slot_t *s = &file_slots[i];
+        if (s->open && !s->busy && !strcmp(s->name, name)) {
+            f_close(&s->fil);
+            s->open = 0;
+        }
+    }
+}
+
+static void file_put(FIL *f) {
+    for (int i = 0; i < FILE_SLOTS; i++) {
+        file_slot_t *s = &file_slots[i];
+        if (&s->fil != f) continue;
+        // Written files are closed so the directory entry is committed
+        if (f->flag & FA_WRITE) {
+            f_close(f);
+            s->open = 0;
+        }
+        s->busy = 0;
+    }
+}
+
+// ======================================================================
+// Image catalog
+// CATALOG_FILE lists every received image with its BMP layout, so the
+// slideshow starts at boot without a directory scan or header parsing.
+// It is rewritten as CATALOG_TMP and renamed over the old one; a crash in
+// between leaves the complete CATALOG_TMP, which catalog_load() accepts.
+// ======================================================================
+// CRC-32 (IEEE 802.3, reflected), same result as the CRC accelerator
+static uint32_t crc32_update(uint32_t crc, const uint8_t *p, uint32_t len) {
+    crc = ~crc;
+    while (len--) {
+        crc ^= *p++;
+        for (int k = 0; k < 8; k++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+static int catalog_load(const char *name) {
+    catalog_hdr_t hdr;
     FRESULT res;
-    FATFS fs;
-    FIL fil;
     UINT br;
+    FIL *f = file_get(name, FA_READ, &res);
+    if (!f) return 0;
+
+    int ok = !f_read(f, &hdr, sizeof(hdr), &br) && br == sizeof(hdr)
+          && hdr.magic == CATALOG_MAGIC && hdr.version == CATALOG_VERSION
+          && hdr.count <= MAX_PHOTOS && hdr.next < MAX_PHOTOS;
+    if (ok) {
+        UINT len = hdr.count * sizeof(catalog_entry_t);
+        ok = !f_read(f, catalog, len, &br) && br == len
+          && crc32_update(0, (const uint8_t *)catalog, len) == hdr.crc;
+    }
+    file_put(f);
+    file_forget(name);
 
-    static uint8_t sec_buf[SEC_SIZE];
-    static uint8_t row_buf[((IMG_WIDTH * 2 + 3) & ~3)];
+    if (!ok) return 0;
+    count_photo = hdr.count;
+    photo_next = hdr.next;
+    return 1;
+}
 
-    res = f_mount(&fs, "", 0);
-    if (res) return;
+static void catalog_save(void) {
+    catalog_hdr_t hdr;
+    FRESULT res;
+    UINT bw;
+    UINT len = count_photo * sizeof(catalog_entry_t);
 
-    res = f_open(&fil, filename, FA_READ);
+    hdr.magic = CATALOG_MAGIC;
+    hdr.version = CATALOG_VERSION;
+    hdr.count = count_photo;
+    hdr.next = photo_next;
+    hdr.crc = crc32_update(0, (const uint8_t *)catalog, len);
+
+    FIL *f = file_get(CATALOG_TMP, FA_CREATE_ALWAYS | FA_WRITE, &res);
+    if (!f) return;
+    res = f_write(f, &hdr, sizeof(hdr), &bw);
+    if (!res) res = f_write(f, catalog, len, &bw);
+    file_put(f);
     if (res) {
-        f_mount(0, "", 0);
+        printf("catalog write failed with %d\n", res);
         return;
     }
 
-    uint8_t header[BMP_HEADER];
-    f_read(&fil, header, BMP_HEADER, &br);
+    file_forget(CATALOG_FILE);
+    f_unlink(CATALOG_FILE);
+    f_rename(CATALOG_TMP, CATALOG_FILE);
+}
 
-    uint32_t pixel_offset =
-        (uint32_t)header[10]        |
-        ((uint32_t)header[11] << 8) |
-        ((uint32_t)header[12] << 16)|
-        ((uint32_t)header[13] << 24);
+// Fills e from whichever layouts of image index are on the card, 0 if none
+static int catalog_probe(catalog_entry_t *e, uint32_t index) {
+    FRESULT res;
+    UINT br;
+    FIL *f;
 
-    f_lseek(&fil, pixel_offset);
+    memset(e, 0, sizeof(*e));
+    snprintf(e->name, sizeof(e->name), "image%lu.bmp", (unsigned long)index);
+    snprintf(e->fb_name, sizeof(e->fb_name), "image%lu.fb", (unsigned long)index);
+    snprintf(e->rle_name, sizeof(e->rle_name), "image%lu.rle", (unsigned long)index);
 
-    uint32_t row_size = ((IMG_WIDTH * 2 + 3) & ~3);
-    uint32_t row_bytes = 0;
-    uint32_t bmp_row = 0;
+    f = STORE_RLE ? file_get(e->rle_name, FA_READ, &res) : 0;
+    if (f) {
+        uint8_t header[RLE_HEADER];
+        res = f_read(f, header, RLE_HEADER, &br);
+        if (!res && br == RLE_HEADER && rd32(header) == RLE_MAGIC
+            && rd16(header + 4) == IMG_WIDTH && rd16(header + 6) == IMG_HEIGHT) {
+            e->layouts |= LAYOUT_RLE;
+            e->rle_sclust = f->obj.sclust;
+            e->rle_size = f_size(f);
+            e->width = IMG_WIDTH;
+            e->height = IMG_HEIGHT;
+        }
+        file_put(f);
+    }
 
-    while (bmp_row < IMG_HEIGHT) {
-        f_read(&fil, sec_buf, 512, &br);
-        if (br == 0) break;
+    f = file_get(e->fb_name, FA_READ, &res);
+    if (f) {
+        if (f_size(f) == (FSIZE_t)FB_ROW * IMG_HEIGHT) {
+            e->layouts |= LAYOUT_FB;
+            e->fb_sclust = f->obj.sclust;
+            e->fb_size = f_size(f);
+            e->width = IMG_WIDTH;
+            e->height = IMG_HEIGHT;
+        }
+        file_put(f);
+    }
 
-        uint32_t p = 0;
+    f = file_get(e->name, FA_READ, &res);
+    if (f) {
+        uint8_t header[BMP_HEADER];
+        res = f_read(f, header, BMP_HEADER, &br);
+        if (!res && br == BMP_HEADER) {
+            e->layouts |= LAYOUT_BMP;
+            e->sclust = f->obj.sclust;
+            e->size = f_size(f);
+            e->pixel_offset = rd32(header + 10);
+            e->width = (int32_t)rd32(header + 18);
+            e->height = (int32_t)rd32(header + 22);
+            e->bpp = rd16(header + 28);
+            e->crc = 0;     // not worth reading the whole file for
+        }
+        file_put(f);
+    }
 
-        while (p < br && bmp_row < IMG_HEIGHT)
-        {
-            uint32_t need = row_size - row_bytes;
-            uint32_t remain = br - p;
-            uint32_t take = (remain < need) ? remain : need;
+    return e->layouts != 0;
+}
 
-            memcpy(row_buf + row_bytes, sec_buf + p, take);
+// Rebuilds the catalog from the image files when it is missing or stale
+static void catalog_rescan(void) {
+    memset(catalog, 0, sizeof(catalog));
+    count_photo = 0;
+    photo_next = 0;
+    for (uint32_t i = 0; i < MAX_PHOTOS; i++) {
+        if (!catalog_probe(&catalog[i], i)) break;
+        count_photo = i + 1;
+    }
+    photo_next = count_photo % MAX_PHOTOS;
+    printf("catalog rebuilt with %lu images\n", (unsigned long)count_photo);
+    catalog_save();
+}
 
-            row_bytes += take;
-            p += take;
+// Feeds the BMP pixel array to the stream aperture as a flat byte stream,
+// the window flips the bottom-up rows in hardware
+static UINT display_sink(const BYTE *p, UINT len) {
+    const BYTE *end = p + len;
 
-            if (row_bytes == row_size) {
-                uint32_t fb_row = IMG_HEIGHT - 1 - bmp_row;
-                uint32_t base = fb_row * IMG_WIDTH;
+    while (p < end && (disp_pos & 3)) {
+        disp_word |= (uint32_t)*p++ << (8 * (disp_pos & 3));
+        if (!(++disp_pos & 3)) {
+            *vga_stream = disp_word;
+            disp_word = 0;
+        }
+    }
+    while (end - p >= 4) {
+        *vga_stream = rd32(p);
+        p += 4;
+        disp_pos += 4;
+    }
+    while (p < end) {
+        disp_word |= (uint32_t)*p++ << (8 * (disp_pos & 3));
+        disp_pos++;
+    }
 
-                for (int col = 0; col < IMG_WIDTH; col++) {
-                    uint16_t pixel565 = (row_buf[col * 2 + 1] << 8) | row_buf[col * 2 + 0];
-                    vga_fb[base + col] = pixel565;
-                }
+    return len;
+}
+
+// Framebuffer-native files are already in scanout order, one sequential copy
+// of whole words into the packed aperture
+static UINT display_fb_sink(const BYTE *p, UINT len) {
+    const BYTE *end = p + len;
+
+    if (!((uintptr_t)p & 3) && !(disp_pos & 1)) {
+        while (end - p >= 4 && disp_pos < IMG_WIDTH * IMG_HEIGHT) {
+            vga_fb_packed[disp_pos / 2] = *(const uint32_t *)p;
+            p += 4;
+            disp_pos += 2;
+        }
+    }
+    while (end - p >= 2 && disp_pos < IMG_WIDTH * IMG_HEIGHT) {
+        vga_fb[disp_pos++] = (p[1] << 8) | p[0];
+        p += 2;
+    }
+
+    return len;
+}
+
+// Advances the run-length cursor n pixels along its row, then to the next
+// row: the lower one of the band, or the upper one of the band above
+static void rle_step(uint32_t n) {
+    disp_x += n;
+    if (disp_x == IMG_WIDTH) {
+        disp_x = 0;
+        disp_y = (disp_y & 1) ? disp_y - 3 : disp_y + 1;
+    }
+}
+
+// Paints a run from the cursor on, whole bands and long row pieces as blitter fills
+static void rle_fill(uint16_t color, uint32_t n) {
+    while (n && disp_y < IMG_HEIGHT) {
+        uint32_t w = IMG_WIDTH - disp_x;
+        if (w > n) w = n;
+        if (disp_x == 0 && !(disp_y & 1) && n >= 2 * IMG_WIDTH) {
+            vga_blit_fill(vga_back, 0, disp_y, IMG_WIDTH, 2, color);
+            disp_y -= 2;
+            n -= 2 * IMG_WIDTH;
+            continue;
+        }
+        if (w >= RLE_BLIT_MIN) {
+            vga_blit_fill(vga_back, disp_x, disp_y, w, 1, color);
+        } else {
+            for (uint32_t i = 0; i < w; i++) vga_fb[disp_y * IMG_WIDTH + disp_x + i] = color;
+        }
+        rle_step(w);
+        n -= w;
+    }
+}
+
+// Decodes run-length tokens into the back page. Tokens are 16-bit and
+// sectors even-sized, so a chunk never ends inside one.
+static UINT display_rle_sink(const BYTE *p, UINT len) {
+    const BYTE *end = p + len;
+
+    while (end - p >= 2 && disp_y < IMG_HEIGHT) {
+        if (!rle_left) {
+            uint16_t t = rd16(p);
+            rle_run = t & RLE_RUN;
+            rle_left = t & RLE_MAX;
+            p += 2;
+        } else if (rle_run) {
+            rle_fill(rd16(p), rle_left);
+            rle_left = 0;
+            p += 2;
+        } else if (!(disp_x & 1) && rle_left >= 2 && end - p >= 4) {
+            // Pixel pairs never cross a row, the width is even
+            vga_fb_packed[(disp_y * IMG_WIDTH + disp_x) / 2] = rd32(p);
+            rle_left -= 2;
+            rle_step(2);
+            p += 4;
+        } else {
+            vga_fb[disp_y * IMG_WIDTH + disp_x] = rd16(p);
+            rle_left--;
+            rle_step(1);
+            p += 2;
+        }
+    }
+
+    return len;
+}
+
+// Paints image index into the back page, 1 when it was painted
+static int display_rgb565_image(uint32_t index) {
+    FRESULT res;
+    FIL *fil;
+    UINT br;
+    const catalog_entry_t *e = &catalog[index];
+
+    if (STORE_RLE && (e->layouts & LAYOUT_RLE)) {
+        fil = file_get(e->rle_name, FA_READ, &res);
+        if (!fil) {
+            if (res == FR_NO_FILE) catalog_rescan();
+            return 0;
+        }
+        if (fil->obj.sclust != e->rle_sclust || f_size(fil) != e->rle_size) {
+            file_put(fil);
+            catalog_rescan();
+            return 0;
+        }
+        f_lseek(fil, RLE_HEADER);
+        vga_view(vga_back, IMG_WIDTH, IMG_HEIGHT, 0);
+        disp_x = 0;
+        disp_y = IMG_HEIGHT - 2;
+        rle_left = 0;
+        res = f_stream(fil, display_rle_sink, 0, 0, e->rle_size - RLE_HEADER, &br);
+        file_put(fil);
+        vga_blit_wait();    // fills still running would land after the flip
+        return !res;
+    }
+    if (e->layouts & LAYOUT_FB) {
+        fil = file_get(e->fb_name, FA_READ, &res);
+        if (!fil) {
+            if (res == FR_NO_FILE) catalog_rescan();
+            return 0;
+        }
+        if (fil->obj.sclust != e->fb_sclust || f_size(fil) != e->fb_size) {
+            file_put(fil);
+            catalog_rescan();
+            return 0;
+        }
+        vga_view(vga_back, IMG_WIDTH, IMG_HEIGHT, 0);
+        disp_pos = 0;
+        res = f_stream(fil, display_fb_sink, 0, 0, e->fb_size, &br);
+        file_put(fil);
+        return !res;
+    }
+    if (!(e->layouts & LAYOUT_BMP)) return 0;
+
+    fil = file_get(e->name, FA_READ, &res);
+    if (!fil) {
+        if (res == FR_NO_FILE) catalog_rescan();
+        return 0;
+    }
+    if (fil->obj.sclust != e->sclust || f_size(fil) != e->size) {
+        // The card changed behind the catalog
+        file_put(fil);
+        catalog_rescan();
+        return 0;
+    }
+    // Only bottom-up RGB565 up to 640x480 is painted, smaller ones are
+    // zoomed by the scanout
+    uint32_t w = (uint32_t)e->width, h = (uint32_t)e->height;
+    if (e->bpp != 16 || !w || !h || (w & 1) || w > IMG_WIDTH || h > IMG_HEIGHT) {
+        file_put(fil);
+        return 0;
+    }
+
+    uint32_t pixel_offset = e->pixel_offset;
+    f_lseek(fil, pixel_offset);
+
+    // Rows are consumed in place from the sector cache, no intermediate copy.
+    // An even width has no row padding, so the pixel array is one flat run.
+    vga_blit_wait();
+    vga_view(vga_back, w, h, vga_zoom(w, h));
+    vga->strm_pos = VGA_XY(vga_back, 0, 0);
+    vga->strm_size = VGA_WH(w, h);
+    vga->strm_ctrl = VGA_STRM_FLIP;
+    disp_pos = 0;
+    disp_word = 0;
+    res = f_stream(fil, display_sink, 0, 0, f_size(fil) - pixel_offset, &br);
+
+    file_put(fil);
+    return !res;
+}
+
+// Stored layout of e with fixed row offsets: the framebuffer-native file,
+// else a 640x480 RGB565 BMP. Sets the offset of pixel (0, 0) and the row
+// order, 0 if there is none (run-length only, or a zoomed BMP).
+static uint32_t image_rows(const catalog_entry_t *e, uint32_t *base, int *bottom_up) {
+    if (e->layouts & LAYOUT_FB) {
+        *base = 0;
+        *bottom_up = 0;
+        return LAYOUT_FB;
+    }
+    if ((e->layouts & LAYOUT_BMP) && e->bpp == 16 && e->width == IMG_WIDTH && e->height == IMG_HEIGHT) {
+        *base = e->pixel_offset;
+        *bottom_up = 1;
+        return LAYOUT_BMP;
+    }
+    return 0;
+}
+
+// Paints only the rectangles r[0..n-1] of image index into the back page,
+// seeking to each of their rows in the stored file (see image_rows()).
+// 1 when every rectangle was painted.
+static int display_rects(uint32_t index, const vga_rect_t *r, uint32_t n) {
+    FRESULT res = FR_OK;
+    FIL *fil;
+    UINT br;
+    const catalog_entry_t *e = &catalog[index];
+    uint32_t base;
+    int bottom_up;
+    uint32_t layout = image_rows(e, &base, &bottom_up);
+
+    if (!layout) return 0;
+    fil = file_get(layout == LAYOUT_FB ? e->fb_name : e->name, FA_READ, &res);
+    if (!fil) return 0;
+    if (fil->obj.sclust != (layout == LAYOUT_FB ? e->fb_sclust : e->sclust)
+        || f_size(fil) != (layout == LAYOUT_FB ? e->fb_size : e->size)) {
+        file_put(fil);
+        catalog_rescan();
+        return 0;
+    }
+
+    vga_blit_wait();
+    for (; n && !res; n--, r++) {
+        uint32_t x = r->x, w = r->w, y0 = r->y, y1 = (uint32_t)r->y + r->h;
+        if (x >= IMG_WIDTH || y0 >= IMG_HEIGHT) continue;
+        if (w > IMG_WIDTH - x) w = IMG_WIDTH - x;
+        if (y1 > IMG_HEIGHT) y1 = IMG_HEIGHT;
+        for (uint32_t y = y0; y < y1 && !res; y++) {
+            uint32_t row = bottom_up ? IMG_HEIGHT - 1 - y : y;
+            res = f_lseek(fil, base + (row * IMG_WIDTH + x) * 2);
+            disp_pos = y * IMG_WIDTH + x;
+            if (!res) res = f_stream(fil, display_fb_sink, 0, 0, w * 2, &br);
+        }
+    }
+
+    file_put(fil);
+    return !res;
+}
+
+// Paints image index into the back page like display_rgb565_image(), 1 when
+// it was painted. An image received with dirty rectangles against the one
+// on screen starts from a blitter copy of it and only reads those regions.
+static int display_slide(uint32_t index) {
+    const catalog_entry_t *e = &catalog[index];
+    const vga_view_t *v = &vga_views[vga_shown];
+    int ok = 0;
+
+    if (e->crc && vga_page_crc[vga_back] == e->crc) return 1;
+    vga_page_crc[vga_back] = 0;
+    if (DIRTY_RECTS && e->base_crc && e->base_crc == vga_page_crc[vga_shown] && vga_shown != vga_back
+        && v->w == IMG_WIDTH && v->h == IMG_HEIGHT && !v->scale) {
+        vga_view(vga_back, IMG_WIDTH, IMG_HEIGHT, 0);
+        vga_blit_copy(VGA_XY(vga_back, 0, 0), VGA_XY(vga_shown, 0, 0), IMG_WIDTH, IMG_HEIGHT);
+        ok = display_rects(index, e->rects, e->n_rects);
+        // A tile patch of the page on screen may have run in between
+        if (vga_page_crc[vga_shown] != e->base_crc) ok = 0;
+    }
+    if (!ok) {
+        vga_blit_wait();    // a copy left running would land on the repaint
+        ok = display_rgb565_image(index);
+    }
+    if (ok) vga_page_crc[vga_back] = e->crc;
+    return ok;
+}
+
+// ======================================================================
+// Tile patches
+// A TYPE_DELTA transfer names an image on the card by its crc and sends
+// only the 16x16 tiles that changed. They are written at their row
+// offsets into a copy of its row-addressable file in the next slot, or
+// into the file itself with DELTA_INPLACE. While the base is on screen,
+// each tile is painted there as it arrives.
+// ======================================================================
+// Removes the files of e's slot in the layouts it does not list
+static void image_drop(const catalog_entry_t *e) {
+    if (!(e->layouts & LAYOUT_BMP)) {
+        file_forget(e->name);
+        f_unlink(e->name);
+    }
+    if (!(e->layouts & LAYOUT_FB)) {
+        file_forget(e->fb_name);
+        f_unlink(e->fb_name);
+    }
+    if (!(e->layouts & LAYOUT_RLE)) {
+        file_forget(e->rle_name);
+        f_unlink(e->rle_name);
+    }
+}
+
+// Copies image file src to dst a sector at a time and returns dst, still
+// open for the patch writes
+static FIL *delta_copy(const char *src, const char *dst, FRESULT *res) {
+    UINT br, bw;
+    FIL *in = file_get(src, FA_READ, res);
+    if (!in) return 0;
+    FIL *out = file_get(dst, FA_CREATE_ALWAYS | FA_WRITE | FA_READ, res);
+    if (!out) {
+        file_put(in);
+        return 0;
+    }
+
+    do {
+        *res = f_read(in, write_buf, SEC_SIZE, &br);
+        if (!*res && br) {
+            *res = f_write(out, write_buf, br, &bw);
+            if (!*res && bw != br) *res = FR_DENIED;
+        }
+    } while (!*res && br == SEC_SIZE);
+    file_put(in);
+    if (*res) {
+        file_put(out);
+        return 0;
+    }
+    return out;
+}
+
+// Writes tile records into delta_fil, one seek per piece of a tile row.
+// Records run across DATA frames.
+static FRESULT rx_patch(const uint8_t *p, uint32_t len) {
+    FRESULT res = FR_OK;
+    UINT bw;
+    const uint8_t *end = p + len;
 
-                bmp_row++;
-                row_bytes = 0;
+    while (p < end && !res) {
+        if (rx_tile_pos < 2) {
+            rx_tile = rx_tile_pos ? rx_tile | (uint32_t)*p << 8 : *p;
+            rx_tile_pos++;
+            p++;
+            if (rx_tile_pos == 2 && rx_tile >= TILE_COLS * (IMG_HEIGHT / TILE)) res = FR_INVALID_PARAMETER;
+            continue;
+        }
+
+        uint32_t k = rx_tile_pos - 2;       // byte within the tile
+        uint32_t n = TILE_ROW - k % TILE_ROW;
+        if (n > (uint32_t)(end - p)) n = end - p;
+        uint32_t x = rx_tile % TILE_COLS * TILE;
+        uint32_t y = rx_tile / TILE_COLS * TILE + k / TILE_ROW;
+        uint32_t row = rx_delta_up ? IMG_HEIGHT - 1 - y : y;
+
+        res = f_lseek(delta_fil, rx_delta_base + row * FB_ROW + x * 2 + k % TILE_ROW);
+        if (!res) res = f_write(delta_fil, p, n, &bw);
+        if (!res && bw != n) res = FR_DENIED;
+
+        if (rx_delta_live) {
+            // Write page switched to the one on screen and back, the
+            // FIFO takes the page with each write
+            uint32_t wpage = vga->wpage;
+            vga->wpage = vga_shown;
+            for (uint32_t i = 0; i < n; i++) {
+                if (!((k + i) & 1)) {
+                    rx_tile_lo = p[i];
+                } else {
+                    vga_fb[y * IMG_WIDTH + x + (k + i) % TILE_ROW / 2] = rx_tile_lo | (p[i] << 8);
+                }
             }
+            vga->wpage = wpage;
         }
+
+        p += n;
+        rx_tile_pos += n;
+        if (rx_tile_pos == TILE_REC) rx_tile_pos = 0;
     }
 
-    f_close(&fil);
-    f_mount(0, "", 0);
+    return res;
+}
+
+// Last tile written: record the patched image and show it next
+static void rx_patch_end(void) {
+    catalog_entry_t *e = &catalog[rx_delta_dst];
+
+    if (rx_delta_dst != rx_delta_src) {
+        *e = catalog[rx_delta_src];
+        snprintf(e->name, sizeof(e->name), "image%lu.bmp", (unsigned long)rx_delta_dst);
+        snprintf(e->fb_name, sizeof(e->fb_name), "image%lu.fb", (unsigned long)rx_delta_dst);
+        snprintf(e->rle_name, sizeof(e->rle_name), "image%lu.rle", (unsigned long)rx_delta_dst);
+        e->layouts = rx_delta_layout;
+    }
+    e->crc = rx_delta_crc;
+    e->base_crc = 0;
+    e->n_rects = 0;
+    if (rx_delta_layout == LAYOUT_FB) {
+        e->fb_sclust = delta_fil->obj.sclust;
+        e->fb_size = f_size(delta_fil);
+    } else {
+        e->sclust = delta_fil->obj.sclust;
+        e->size = f_size(delta_fil);
+    }
+    file_put(delta_fil);
+    delta_fil = 0;
+    image_drop(e);
+
+    // The screen already shows the patched image, so does the back page
+    // after one copy, and the slideshow goes on from there
+    if (rx_delta_live) {
+        vga_page_crc[vga_shown] = e->crc;
+        vga_views[vga_back] = vga_views[vga_shown];
+        vga_blit_copy(VGA_XY(vga_back, 0, 0), VGA_XY(vga_shown, 0, 0), IMG_WIDTH, IMG_HEIGHT);
+        vga_blit_wait();
+        vga_page_crc[vga_back] = e->crc;
+    }
+    rx_delta = 0;
+    file_opened = 0;
+    transfer_info.active = 0;
+    status_show("");
+
+    photo_offset = rx_delta_dst;
+    if (rx_delta_dst != rx_delta_src) {
+        photo_next = (photo_next + 1) % MAX_PHOTOS;
+        if (count_photo < MAX_PHOTOS) count_photo++;
+    }
+    catalog_save();
+
+    search_next_image();
+}
+
+// ======================================================================
+// Image store
+// A received BMP is transcoded on the fly into the framebuffer-native
+// layout (image%d.fb). Bottom-up BMP rows arrive in pairs and each pair
+// is exactly five sectors top-down, so every write is sector aligned.
+// 24 and 32 bpp rows are dithered down to RGB565 on the way. Smaller
+// RGB565 images are only kept as BMPs, the scanout zooms them. Other
+// sizes are resized to fit and letterboxed by scale.c, which hands the
+// rows back bottom-up as well. Finished rows are also painted into
+// VGA_RX_PAGE, which stays on screen until the image is complete and
+// then becomes the slide without being read back.
+// The BMP itself is kept with KEEP_BMP, or when it cannot be transcoded.
+// ======================================================================
+// Opens the files for the layouts the BMP header allows, 0 on failure
+static int rx_begin(void) {
+    FRESULT res = FR_OK;
+    uint32_t bpp = rd16(rx_header + 28);
+    uint32_t width = rd32(rx_header + 18);
+    uint32_t height = rd32(rx_header + 22);     // top-down BMPs are negative and do not fit
+    int native = width == IMG_WIDTH && height == IMG_HEIGHT;
+    int zoomed = !native && bpp == 16 && width && height && !(width & 1)
+              && width <= IMG_WIDTH && height <= IMG_HEIGHT;
+    int transcode = (native || (RESIZE_BMP && !zoomed && scale_fits(width, height)))
+                 && rd32(rx_header + 10) >= BMP_HEADER
+                 && (bpp == 16 || ((bpp == 24 || bpp == 32) && rd32(rx_header + 30) == 0));   // BI_RGB
+
+    if (KEEP_BMP || !transcode) {
+        fil = file_get(filename, FA_CREATE_ALWAYS | FA_WRITE, &res);
+        // The header arrived before the file existed
+        memcpy(write_buf, rx_header, BMP_HEADER);
+        write_bytes = BMP_HEADER;
+    }
+    if (!res && transcode) {
+        fb_fil = file_get(fb_filename, FA_CREATE_ALWAYS | FA_WRITE, &res);
+        fb_pairs = 0;
+        rx_scaled = !native;
+        rx_scale_res = FR_OK;
+    }
+    // Best effort, and only when a file slot is left over
+    if (!res && transcode && STORE_RLE && !fil) {
+        rle_fil = file_get(rle_filename, FA_CREATE_ALWAYS | FA_WRITE, &rle_res);
+        if (rle_fil) {
+            rle_bytes = 0;
+            rle_word(RLE_MAGIC & 0xFFFF);
+            rle_word(RLE_MAGIC >> 16);
+            rle_word(IMG_WIDTH);
+            rle_word(IMG_HEIGHT);
+        }
+    }
+    if (res) {
+        printf("f_open for dst failed with %d\n", res);
+        rx_abort(FR_OK);
+        return 0;
+    }
+    rx_zoomed = zoomed;
+    rx_preview = transcode || zoomed;
+    if (rx_preview) {
+        rx_shown = 0;
+        rx_preview_done = 0;
+        if (zoomed) vga_view(VGA_RX_PAGE, width, height, vga_zoom(width, height));
+        else vga_view(VGA_RX_PAGE, IMG_WIDTH, IMG_HEIGHT, 0);
+        vga_blit_fill(VGA_RX_PAGE, 0, 0, IMG_WIDTH, IMG_HEIGHT, 0x0000);
+        vga_blit_wait();    // or it could clear rows painted after it
+        vga_show(VGA_RX_PAGE);
+    }
+    if (RESIZE_BMP && transcode && rx_scaled) scale_begin(width, height, rx_row_begin, rx_row_end);
+    return 1;
+}
+
+static void rx_abort(FRESULT res) {
+    if (res) {
+        char line[VGA_TXT_COLS + 1];
+        printf("f_write failed with %d\n", res);
+        snprintf(line, sizeof(line), "%s: write failed (%d)", filename, res);
+        status_show(line);
+    }
+    if (fil) file_put(fil);
+    if (fb_fil) file_put(fb_fil);
+    if (rle_fil) file_put(rle_fil);
+    if (delta_fil) file_put(delta_fil);
+    fil = 0;
+    fb_fil = 0;
+    rle_fil = 0;
+    delta_fil = 0;
+    if (rx_delta && rx_delta_live) vga_page_crc[vga_shown] = 0;    // half patched
+    rx_delta = 0;
+    rx_preview = 0;
+    rx_zoomed = 0;
+    file_opened = 0;
+    transfer_info.active = 0;
+}
+
+// Appends to the BMP in whole sectors
+static FRESULT rx_write_bmp(const uint8_t *p, uint32_t len) {
+    UINT bw;
+    FRESULT res;
+
+    uint32_t pos = 0;
+    while (pos < len) {
+        uint32_t space = SEC_SIZE - write_bytes;
+        uint32_t copy = len - pos;
+        if (copy > space) copy = space;
+
+        memcpy(write_buf + write_bytes, p + pos, copy);
+        write_bytes += copy;
+        pos += copy;
+
+        if (write_bytes == SEC_SIZE) {
+            res = f_write(fil, write_buf, SEC_SIZE, &bw);
+            if (res != FR_OK || bw != SEC_SIZE) return res ? res : FR_DENIED;
+            write_bytes = 0;
+        }
+    }
+    return FR_OK;
+}
+
+// Places BMP bytes [pos, pos + len) at their top-down position in fb_fil
+static FRESULT rx_transcode(const uint8_t *p, uint32_t len, uint32_t pos) {
+    const uint32_t bpp = rd16(rx_header + 28);
+    const uint32_t width = rd32(rx_header + 18);
+    const uint32_t height = rd32(rx_header + 22);
+    const uint32_t row_bytes = width * (bpp / 8);
+    const uint32_t row_size = ((row_bytes + 3) & ~3);
+    const uint32_t pixel_offset = rd32(rx_header + 10);
+    FRESULT res;
+
+    while (len) {
+        if (pos < pixel_offset) {
+            uint32_t skip = pixel_offset - pos;
+            if (skip > len) skip = len;
+            p += skip;
+            pos += skip;
+            len -= skip;
+            continue;
+        }
+        uint32_t row = (pos - pixel_offset) / row_size;
+        uint32_t col = (pos - pixel_offset) % row_size;
+        if (row >= height) break;
+
+        uint32_t n = row_size - col;
+        if (n > len) n = len;
+        if (col < row_bytes) {
+            uint32_t m = row_bytes - col;
+            if (m > n) m = n;
+            // BMP row 2k+1 is the upper one of its pair on screen
+            uint8_t *dst = fb_rows + ((row & 1) ? 0 : FB_ROW);
+            if (RESIZE_BMP && rx_scaled) rx_scale(p, m, col, bpp);
+            else if (rx_zoomed) memcpy(fb_rows + col, p, m);
+            else if (bpp == 16) memcpy(dst + col, p, m);
+            else rx_convert(dst, p, m, col, IMG_HEIGHT - 1 - row, bpp);
+        }
+        p += n;
+        pos += n;
+        len -= n;
+
+        if (rx_zoomed) {
+            if (col + n == row_size) rx_preview_rows((const uint32_t *)fb_rows, height - 1 - row, width, 1);
+        } else if (!rx_scaled && (row & 1) && col + n == row_size) {
+            res = rx_put_pair(IMG_HEIGHT - 1 - row);
+            if (res) return res;
+        }
+    }
+    return rx_scale_res;
+}
+
+// Writes fb_rows at screen rows y and y + 1
+static FRESULT rx_put_pair(uint32_t y) {
+    UINT bw;
+
+    FRESULT res = f_lseek(fb_fil, (FSIZE_t)y * FB_ROW);
+    if (!res) res = f_write(fb_fil, fb_rows, 2 * FB_ROW, &bw);
+    if (res != FR_OK || bw != 2 * FB_ROW) return res ? res : FR_DENIED;
+    fb_pairs++;
+    if (STORE_RLE && rle_fil) rle_put((const uint16_t *)fb_rows, 2 * IMG_WIDTH);
+    if (rx_preview) rx_preview_rows((const uint32_t *)fb_rows, y, IMG_WIDTH, 2);
+    return FR_OK;
+}
+
+// Paints n finished rows, w pixels each, at row y of VGA_RX_PAGE. The
+// slideshow only uses the stream window with no receive in between.
+static void rx_preview_rows(const uint32_t *px, uint32_t y, uint32_t w, uint32_t n) {
+    vga->strm_pos = VGA_XY(VGA_RX_PAGE, 0, y);
+    vga->strm_size = VGA_WH(w, n);
+    vga->strm_ctrl = 0;
+    for (uint32_t i = 0; i < w * n / 2; i++) *vga_stream = px[i];
+    rx_shown += n;
+}
+
+// Makes a complete preview the back page, 1 when there was one. The
+// image is already in the SRAM, so it is not read back from the card.
+static int rx_preview_take(void) {
+    const vga_view_t *v = &vga_views[VGA_RX_PAGE];
+
+    if (!rx_preview_done) return 0;
+    rx_preview_done = 0;
+    vga_views[vga_back] = *v;
+    vga_blit_copy(VGA_XY(vga_back, 0, 0), VGA_XY(VGA_RX_PAGE, 0, 0), v->w, v->h);
+    vga_blit_wait();
+    vga_page_crc[vga_back] = catalog[photo_offset].crc;
+    return 1;
+}
+
+// scale.c row callbacks, the rows come bottom-up so an even y closes a pair
+static uint16_t *rx_row_begin(uint32_t y) {
+    return (uint16_t *)(fb_rows + ((y & 1) ? FB_ROW : 0));
+}
+
+static void rx_row_end(uint32_t y) {
+    if (!(y & 1) && !rx_scale_res) rx_scale_res = rx_put_pair(y);
+}
+
+// Appends one token word to rle_fil, a sector at a time. A failed write
+// only drops the run-length copy, so it is remembered in rle_res.
+static void rle_word(uint16_t v) {
+    UINT bw;
+
+    rle_buf[rle_bytes++] = (uint8_t)v;
+    rle_buf[rle_bytes++] = (uint8_t)(v >> 8);
+    if (rle_bytes == SEC_SIZE) {
+        if (!rle_res) {
+            rle_res = f_write(rle_fil, rle_buf, SEC_SIZE, &bw);
+            if (!rle_res && bw != SEC_SIZE) rle_res = FR_DENIED;
+        }
+        rle_bytes = 0;
+    }
+}
+
+// Length of the run starting at px[0], at most RLE_MAX
+static uint32_t rle_repeat(const uint16_t *px, uint32_t n) {
+    uint32_t run = 1;
+
+    while (run < n && run < RLE_MAX && px[run] == px[0]) run++;
+    return run;
+}
+
+// Encodes one band: runs of RLE_MIN_RUN or more, literals in between
+static void rle_put(const uint16_t *px, uint32_t n) {
+    uint32_t i = 0;
+
+    while (i < n) {
+        uint32_t run = rle_repeat(px + i, n - i);
+        if (run >= RLE_MIN_RUN) {
+            rle_word(RLE_RUN | run);
+            rle_word(px[i]);
+            i += run;
+            continue;
+        }
+        uint32_t j = i + run;
+        while (j < n && j - i < RLE_MAX && rle_repeat(px + j, RLE_MIN_RUN < n - j ? RLE_MIN_RUN : n - j) < RLE_MIN_RUN) j++;
+        rle_word(j - i);
+        for (; i < j; i++) rle_word(px[i]);
+    }
+}
+
+// Dithers len bytes of a 24/32 bpp row, starting at byte col, into the
+// RGB565 row at screen line y. A pixel cut by the end of the frame is
+// finished from rx_carry by the next one.
+static void rx_convert(uint8_t *row, const uint8_t *p, uint32_t len, uint32_t col, uint32_t y, uint32_t bpp) {
+    const uint32_t step = bpp / 8;
+    uint32_t x = col / step;
+    uint32_t part = col % step;
+
+    if (part) {
+        uint32_t k = step - part;
+        if (k > len) k = len;
+        memcpy(rx_carry + part, p, k);
+        p += k;
+        len -= k;
+        if (part + k < step) return;
+        rgb565_row((uint16_t *)row + x, rx_carry, 1, x, y, bpp);
+        x++;
+    }
+    uint32_t n = len / step;
+    rgb565_row((uint16_t *)row + x, p, n, x, y, bpp);
+    memcpy(rx_carry, p + n * step, len - n * step);
+}
+
+// One source pixel to scale_pixel(), 16 bpp being RGB565 like elsewhere
+static void rx_scale_px(const uint8_t *s, uint32_t bpp) {
+    if (bpp == 16) {
+        uint32_t v = s[0] | (uint32_t)s[1] << 8;
+        uint32_t r = v >> 11, g = (v >> 5) & 0x3F, b = v & 0x1F;
+        scale_pixel(r << 3 | r >> 2, g << 2 | g >> 4, b << 3 | b >> 2);
+    } else {
+        scale_pixel(s[2], s[1], s[0]);
+    }
+}
+
+// Feeds len bytes of a source row, starting at byte col, to scale_pixel().
+// A pixel cut by the end of the frame is finished from rx_carry.
+static void rx_scale(const uint8_t *p, uint32_t len, uint32_t col, uint32_t bpp) {
+    const uint32_t step = bpp / 8;
+    uint32_t part = col % step;
+
+    if (part) {
+        uint32_t k = step - part;
+        if (k > len) k = len;
+        memcpy(rx_carry + part, p, k);
+        p += k;
+        len -= k;
+        if (part + k < step) return;
+        rx_scale_px(rx_carry, bpp);
+    }
+    for (; len >= step; p += step, len -= step) rx_scale_px(p, bpp);
+    memcpy(rx_carry, p, len);
+}
+
+// Shows the back page from the next frame on, then paints the other one.
+// While an image is being received its preview stays on screen instead.
+static void vga_flip(void) {
+    uint32_t front = vga_back;
+
+    vga_show(rx_preview ? VGA_RX_PAGE : front);
+    // No uart_rx() here: a frame handled now would re-enter the caller,
+    // uart_poll() keeps the bytes until the main loop takes them
+    while (vga->front & VGA_FRONT_PENDING) cpu_idle();
+    vga_back = front ? 0 : 1;
+    vga->wpage = vga_back;
+}
+
+// Puts page on screen with its view from the next frame on, no wait
+static void vga_show(uint32_t page) {
+    const vga_view_t *v = &vga_views[page];
+
+    vga->view_pos = VGA_XY(0, (IMG_WIDTH - (v->w << v->scale)) / 2, (IMG_HEIGHT - (v->h << v->scale)) / 2);
+    vga->view_size = VGA_WH(v->w, v->h);
+    vga->scale = v->scale;
+    vga->front = page;
+    vga_shown = page;
+}
+
+// How vga_show() presents page: a w x h image stored top-left in it,
+// centred, each pixel shown 1 << scale times over
+static void vga_view(uint32_t page, uint32_t w, uint32_t h, uint32_t scale) {
+    vga_views[page].w = w;
+    vga_views[page].h = h;
+    vga_views[page].scale = scale;
+}
+
+// Largest integer zoom that keeps a w x h image on screen
+static uint32_t vga_zoom(uint32_t w, uint32_t h) {
+    uint32_t scale = 0;
+
+    while (scale < VGA_SCALE_MAX && (w << (scale + 1)) <= IMG_WIDTH && (h << (scale + 1)) <= IMG_HEIGHT) scale++;
+    return scale;
+}
+
+// Fills a rectangle of one page with a solid color
+static void vga_blit_fill(uint32_t page, uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint16_t color) {
+    vga_blit_wait();
+    vga->blt_dst = VGA_XY(page, x, y);
+    vga->blt_size = VGA_WH(w, h);
+    vga->blt_color = color;
+    vga->blt_ctrl = VGA_BLT_ROP_COPY | VGA_BLT_START;
+}
+
+// Copies a rectangle, dst and src from VGA_XY(). Overlap is allowed,
+// so this also scrolls a region within a page.
+static void vga_blit_copy(uint32_t dst, uint32_t src, uint32_t w, uint32_t h) {
+    vga_blit_wait();
+    vga->blt_src = src;
+    vga->blt_dst = dst;
+    vga->blt_size = VGA_WH(w, h);
+    vga->blt_ctrl = VGA_BLT_ROP_COPY | VGA_BLT_SRC_MEM | VGA_BLT_START;
+}
+
+// Frames started since reset, a free-running display clock
+static uint32_t vga_frame(void) {
+    return vga->frame;
+}
+
+// Returns at the start of the next vertical blank
+static void vga_wait_vblank(void) {
+    uint32_t frame = vga->frame;
+
+    while (vga->frame == frame) cpu_idle();
+}
+
+// Calls hook from the interrupt at every vblank start, 0 turns it off
+static void vga_on_vblank(void (*hook)(uint32_t frame)) {
+    vblank_hook = hook;
+    vga->vbl_ctrl = (hook ? VGA_VBL_IRQ_EN : 0) | VGA_VBL_PENDING;
+}
+
+// Image pixel shown at the top-left of the view, wrapping around the
+// image. Taken at the start of every frame, so a scroll never tears.
+static void vga_scroll(int32_t x, int32_t y) {
+    int32_t w = (int32_t)vga_views[vga_shown].w, h = (int32_t)vga_views[vga_shown].h;
+
+    x %= w;
+    y %= h;
+    vga->scroll = VGA_XY(0, x < 0 ? x + w : x, y < 0 ? y + h : y);
+}
+
+// Moves screen line y left by dx image pixels (right when negative) on
+// top of the scroll, |dx| below the view width. Used when the line is
+// fetched, so effects rewrite the table from the vblank hook.
+static void vga_line_offset(uint32_t y, int32_t dx) {
+    vga_hofs[y] = (uint32_t)dx & 0x3FF;
+}
+
+// Vblank hook: every line swings sideways along a sine of its height,
+// and the sine drifts down the screen from frame to frame
+static void vga_wave(uint32_t frame) {
+    static const int8_t wave_sin[64] = {
+        0, 12, 25, 37, 49, 60, 71, 81, 90, 98, 106, 112, 117, 122, 125, 126,
+        127, 126, 125, 122, 117, 112, 106, 98, 90, 81, 71, 60, 49, 37, 25, 12,
+        0, -12, -25, -37, -49, -60, -71, -81, -90, -98, -106, -112, -117, -122, -125, -126,
+        -127, -126, -125, -122, -117, -112, -106, -98, -90, -81, -71, -60, -49, -37, -25, -12,
+    };
+    static int8_t dx[64];    // not on the interrupt stack, the whole stack is 1 KB
+    uint32_t phase = frame * WAVE_SPEED;
+
+    // Image pixels, so a zoomed slide moves as far on screen
+    for (uint32_t i = 0; i < 64; i++) dx[i] = (wave_sin[i] * WAVE_AMP / 127) >> vga_views[vga_shown].scale;
+    for (uint32_t y = 0; y < IMG_HEIGHT; y++) vga_line_offset(y, dx[(y - phase) & 63]);
+}
+
+// Square root of a 64-bit value, rounded down
+static uint32_t isqrt(uint64_t v) {
+    uint64_t r = 0;
+
+    for (uint64_t bit = (uint64_t)1 << 62; bit; bit >>= 2) {
+        if (v >= r + bit) {
+            v -= r + bit;
+            r = (r >> 1) + bit;
+        } else {
+            r >>= 1;
+        }
+    }
+    return (uint32_t)r;
+}
+
+// DAC level of field value v out of max: 255 * (v / max) ^ (quarters / 4)
+static uint32_t vga_gamma_level(uint32_t v, uint32_t max, uint32_t quarters) {
+    uint32_t x = v * 65536 / max;                                   // Q16
+    uint32_t r = isqrt((uint64_t)isqrt((uint64_t)x << 16) << 16);   // x ^ 1/4
+    uint32_t y = 65536;
+
+    while (quarters--) y = (uint32_t)((uint64_t)y * r >> 16);
+    return (y * 255 + 32768) >> 16;
+}
+
+// Loads all three output LUTs with one gamma curve, in quarters so no
+// floating point is needed. Unlike zero padding, full scale is 255.
+static void vga_gamma(uint32_t quarters) {
+    for (uint32_t v = 0; v < 64; v++) {
+        vga_lut[VGA_LUT_G + v] = vga_gamma_level(v, 63, quarters);
+        if (v < 32) {
+            uint32_t level = vga_gamma_level(v, 31, quarters);
+            vga_lut[VGA_LUT_R + v] = level;
+            vga_lut[VGA_LUT_B + v] = level;
+        }
+    }
+}
+
+// Output gain, 0 (black) to VGA_BRIGHT_MAX, for dimming and fades
+static void vga_brightness(uint32_t level) {
+    vga->bright = level;
+}
+
+// Writes s into the overlay from (col, row), clipped at the end of the row.
+// Returns the column after the last character.
+static uint32_t vga_text(uint32_t col, uint32_t row, const char *s, uint32_t fg, uint32_t bg) {
+    for (; *s && col < VGA_TXT_COLS; s++, col++) {
+        vga_txt[row * VGA_TXT_COLS + col] = VGA_TXT_CELL(*s, fg, bg);
+    }
+    return col;
+}
+
+// Every cell blank on the transparent palette entry
+static void vga_text_clear(void) {
+    for (uint32_t i = 0; i < VGA_TXT_COLS * VGA_TXT_ROWS; i++) vga_txt[i] = 0;
+}
+
+// Replaces the status line, an empty string removes it. The rest of the
+// row is blanked too, so the bar keeps its width.
+static void status_show(const char *s) {
+    uint32_t col = 0;
+
+    if (*s) col = vga_text(0, TXT_STATUS_ROW, s, TXT_FG, TXT_BG);
+    for (; col < VGA_TXT_COLS; col++) {
+        vga_txt[TXT_STATUS_ROW * VGA_TXT_COLS + col] = *s ? VGA_TXT_CELL(' ', TXT_FG, TXT_BG) : 0;
+    }
+}
+
+// Blits and CPU writes share the SRAM without ordering, so wait before
+// touching pixels a blit is still writing
+static void vga_blit_wait(void) {
+    while (vga->blt_status & VGA_BLT_BUSY);
 }
 
 // ENDIAN LOADER
@@ -211,20 +1671,42 @@ static inline uint32_t rd32(const uint8_t *p) {
          | ((uint32_t)p[3] << 24);
 }
 
-static void uart_rx(void) {
+// Timer interrupt, every UART_POLL_TICKS: moves the RX FIFO to uart_ring
+// before it can overflow, whatever the main loop is blocked on
+static void uart_poll(void) {
     if ((uart->rxstate) & 0x1) {
         uint32_t rxdata = uart -> rxdata;
         uint8_t fifoCount = rxdata >> 24;
         if (fifoCount == 0) fifoCount = 1;   
         if (fifoCount > 3)  fifoCount = 3;
         for (uint8_t i = 0; i < fifoCount; i++) {
-            uint8_t b = rxdata & 0xFF;
-            split_byte_stream(b);
-            rxdata >> 8;
+            if (uart_head - uart_tail < UART_RING) {
+                uart_ring[uart_head % UART_RING] = rxdata & 0xFF;
+                uart_head++;
+            } else {
+                uart_overruns++;
+            }
+            rxdata >>= 8;
         }
     }
 }
 
+// Feeds the bytes queued by uart_poll() to the SLIP decoder
+static void uart_rx(void) {
+    if (uart_overruns != uart_overruns_seen) {
+        char line[VGA_TXT_COLS + 1];
+        uart_overruns_seen = uart_overruns;
+        printf("uart: %lu bytes dropped\n", (unsigned long)uart_overruns_seen);
+        snprintf(line, sizeof(line), "UART overrun, %lu bytes lost", (unsigned long)uart_overruns_seen);
+        status_show(line);
+    }
+    while (uart_tail != uart_head) {
+        uint8_t b = uart_ring[uart_tail % UART_RING];
+        uart_tail++;
+        split_byte_stream(b);
+    }
+}
+
 static void split_byte_stream(uint8_t byte){
     switch(byte) {
     case END:
@@ -266,6 +1748,13 @@ static void handle_frame(uint8_t *buf, uint32_t frame_num){
     else if (type == TYPE_DATA) {
         handle_data(buf, frame_num); 
     }
+    else if (type == TYPE_DELTA && TILE_DELTA) {
+        handle_delta(buf, frame_num);
+    }
+    else if (type == TYPE_DELTA) {
+        send_ack(BAD);      // the sender falls back to the whole image
+        uart_rx();
+    }
 }
 
 // META Frame Handler
@@ -280,6 +1769,12 @@ static void handle_meta(const uint8_t *buf, uint32_t frame_num) {
     uint8_t  fname_len  = buf[12];
     if (13u + (uint32_t)fname_len > frame_num) return;  // check the range
     if (fname_len > 255) fname_len = 255;
+    if (chunk_size == 0 || chunk_size > MAX_CHUNK) {
+        printf("chunk %u over %u\n", chunk_size, MAX_CHUNK);
+        send_ack(BAD);
+        uart_rx();
+        return;
+    }
     
     // init receive session
     memset(&transfer_info, 0, sizeof(transfer_info));
@@ -295,32 +1790,44 @@ static void handle_meta(const uint8_t *buf, uint32_t frame_num) {
     }
     transfer_info.fname[fname_len] = '\0';
 
-    write_bytes = 0;
-
-    // Send the data to SD
-    snprintf(filename, sizeof(filename), "image%d.bmp", count_photo);
-
-    // Mount
-    FRESULT res;
-    res = f_mount(&fs, "", 0);
-    if (res) {
-        file_opened = 0;
-        transfer_info.active = 0;
-        printf("f_mount failed with %d\n", res);
+    // Version 2: dirty rectangles against the image sent before this one
+    const uint8_t *d = buf + 13 + fname_len;
+    rx_base_crc = 0;
+    rx_n_rects = 0;
+    if (DIRTY_RECTS && buf[1] >= 2 && 13u + fname_len + 5 <= frame_num) {
+        uint32_t n = d[4];
+        if (n <= DIRTY_MAX && 13u + fname_len + 5 + 8 * n <= frame_num) {
+            rx_base_crc = rd32(d);
+            rx_n_rects = n;
+            for (uint32_t i = 0; i < n; i++) {
+                rx_rects[i].x = rd16(d + 5 + 8 * i);
+                rx_rects[i].y = rd16(d + 7 + 8 * i);
+                rx_rects[i].w = rd16(d + 9 + 8 * i);
+                rx_rects[i].h = rd16(d + 11 + 8 * i);
+            }
+        }
     }
 
-    // Create file in SD
-    res = f_open(&fil, filename, FA_CREATE_ALWAYS | FA_WRITE);
+    write_bytes = 0;
+    rx_crc = 0;
+    rx_percent = ~0u;
+    rx_delta = 0;
 
-    if (res) {
-        f_close(&fil);
-        f_mount(0, "", 0);
+    // Send the data to SD, the files are created by rx_begin() once the BMP header is in
+    snprintf(filename, sizeof(filename), "image%lu.bmp", (unsigned long)photo_next);
+    snprintf(fb_filename, sizeof(fb_filename), "image%lu.fb", (unsigned long)photo_next);
+    snprintf(rle_filename, sizeof(rle_filename), "image%lu.rle", (unsigned long)photo_next);
+    fil = 0;
+    fb_fil = 0;
+    rle_fil = 0;
+
+    if (total_size < BMP_HEADER) {
         file_opened = 0;
         transfer_info.active = 0;
-        printf("f_open for dst failed with %d\n", res);
+        printf("image too small: %lu bytes\n", (unsigned long)total_size);
+    } else {
+        file_opened = 1;
     }
-
-    file_opened = 1;
     send_ack(ACK);
     uart_rx();
 }
@@ -363,46 +1870,58 @@ static void handle_data(const uint8_t *buf, uint32_t frame_num_in){
 
     if (file_opened == 0) return;
 
-    // Write data to SD
     UINT bw;
-    FRESULT res;
+    FRESULT res = FR_OK;
 
-    uint32_t pos = 0;
-    while (pos < payload_len) {
-        uint32_t space = SEC_SIZE - write_bytes;
-        uint32_t copy = payload_len - pos;
-        if (copy > space) copy = space;
-
-        memcpy(write_buf + write_bytes, payload + pos, copy);
-        write_bytes += copy;
-        pos += copy;
-
-        if (write_bytes == SEC_SIZE) {
-            res = f_write(&fil, write_buf, SEC_SIZE, &bw);
-            if (res != FR_OK || bw != SEC_SIZE) {
-                f_close(&fil);
-                f_mount(0, "", 0);
-                file_opened = 0;
-                transfer_info.active = 0;
-                printf("f_write failed with %d\n", res);
+    if (TILE_DELTA && rx_delta) {
+        res = rx_patch(payload, payload_len);
+    } else {
+        // Keep the header for the catalog and the CRC of the whole file
+        uint32_t pos = transfer_info.received;
+        uint32_t skip = 0;
+        if (pos < BMP_HEADER) {
+            skip = BMP_HEADER - pos;
+            if (skip > payload_len) skip = payload_len;
+            memcpy(rx_header + pos, payload, skip);
+            if (pos + skip == BMP_HEADER && !rx_begin()) {
+                // rx_begin() already reset the transfer, tell the sender
+                send_ack(BAD);
+                uart_rx();
                 return;
             }
-            write_bytes = 0;
         }
+        rx_crc = crc32_update(rx_crc, payload, payload_len);
+
+        // Write data to SD
+        if (fil) res = rx_write_bmp(payload + skip, payload_len - skip);
+        if (!res && (fb_fil || rx_zoomed)) res = rx_transcode(payload + skip, payload_len - skip, pos + skip);
+    }
+    if (res) {
+        rx_abort(res);
+        send_ack(BAD);
+        uart_rx();
+        return;
     }
 
     transfer_info.received   += payload_len;
     transfer_info.expect_seq  = seq + 1;
 
+    // A few cell writes when the percentage moves, nothing otherwise
+    uint32_t percent = (uint32_t)((uint64_t)transfer_info.received * 100 / transfer_info.total);
+    if (percent != rx_percent) {
+        char line[VGA_TXT_COLS + 1];
+        rx_percent = percent;
+        snprintf(line, sizeof(line), "%s %s %3lu%%", rx_delta ? "Patching" : "Receiving", filename, (unsigned long)percent);
+        status_show(line);
+    }
+
     if (transfer_info.received == transfer_info.total) {
-        if (write_bytes > 0) {
-            res = f_write(&fil, write_buf, write_bytes, &bw);
+        if (fil && write_bytes > 0) {
+            res = f_write(fil, write_buf, write_bytes, &bw);
             if (res != FR_OK || bw != write_bytes) {
-                f_close(&fil);
-                f_mount(0, "", 0);
-                file_opened = 0;
-                transfer_info.active = 0;
-                printf("f_write failed with %d\n", res);
+                rx_abort(res ? res : FR_DENIED);
+                send_ack(BAD);
+                uart_rx();
                 return;
             }
             write_bytes = 0;
@@ -414,36 +1933,228 @@ static void handle_data(const uint8_t *buf, uint32_t frame_num_in){
     }
 
     if (transfer_info.received == transfer_info.total) {
+        if (TILE_DELTA && rx_delta) {
+            rx_patch_end();
+            return;
+        }
         printf("Received image from PC!\n");
-        f_close(&fil);
-        f_mount(0, "", 0);
+        catalog_entry_t *e = &catalog[photo_next];
+        memset(e, 0, sizeof(*e));
+        snprintf(e->name, sizeof(e->name), "%s", filename);
+        snprintf(e->fb_name, sizeof(e->fb_name), "%s", fb_filename);
+        snprintf(e->rle_name, sizeof(e->rle_name), "%s", rle_filename);
+        e->pixel_offset = rd32(rx_header + 10);
+        e->width = (int32_t)rd32(rx_header + 18);
+        e->height = (int32_t)rd32(rx_header + 22);
+        e->bpp = rd16(rx_header + 28);
+        e->crc = rx_crc;
+        if (e->width == IMG_WIDTH && e->height == IMG_HEIGHT) {
+            // Rectangles are in screen pixels, a resized image has none
+            e->base_crc = rx_base_crc;
+            e->n_rects = rx_n_rects;
+            memcpy(e->rects, rx_rects, sizeof(e->rects));
+        }
+        if (fil) {
+            e->layouts |= LAYOUT_BMP;
+            e->sclust = fil->obj.sclust;
+            e->size = transfer_info.total;
+            file_put(fil);
+        }
+        if (STORE_RLE && rle_fil) {
+            if (!rle_res && rle_bytes) {
+                rle_res = f_write(rle_fil, rle_buf, rle_bytes, &bw);
+                if (!rle_res && bw != rle_bytes) rle_res = FR_DENIED;
+            }
+            uint32_t rle_size = f_size(rle_fil);
+            if (!rle_res && fb_pairs == IMG_HEIGHT / 2
+                && rle_size < (uint64_t)FB_ROW * IMG_HEIGHT * RLE_KEEP / 100) {
+                e->layouts |= LAYOUT_RLE;
+                e->rle_sclust = rle_fil->obj.sclust;
+                e->rle_size = rle_size;
+            }
+            printf("%s: %lu bytes, %lu%% of the raw frame\n", rle_filename, (unsigned long)rle_size,
+                   (unsigned long)((uint64_t)rle_size * 100 / ((uint64_t)FB_ROW * IMG_HEIGHT)));
+            file_put(rle_fil);
+        }
+        if (fb_fil) {
+            // A truncated BMP leaves holes, the native copy is only good when
+            // complete, and not needed next to the run-length one unless
+            // dirty rectangles are painted from its row offsets
+            if (fb_pairs == IMG_HEIGHT / 2 && (!(e->layouts & LAYOUT_RLE) || e->base_crc)) {
+                e->layouts |= LAYOUT_FB;
+                e->fb_sclust = fb_fil->obj.sclust;
+                e->fb_size = f_size(fb_fil);
+            }
+            file_put(fb_fil);
+        }
+        fil = 0;
+        fb_fil = 0;
+        rle_fil = 0;
         file_opened = 0;
         transfer_info.active = 0;
-        display_rgb565_image(filename);
-        photo_offset = count_photo;
-        count_photo++;
+        rx_preview_done = rx_preview && rx_shown == vga_views[VGA_RX_PAGE].h && e->layouts;
+        rx_preview = 0;
+
+        if (!e->layouts) printf("%s could not be stored\n", filename);
+        status_show(e->layouts ? "" : "Received image could not be stored");
+
+        // Drop what this slot held before in a layout not rewritten now
+        image_drop(e);
+
+        photo_offset = photo_next;
+        photo_next = (photo_next + 1) % MAX_PHOTOS;
+        if (count_photo < MAX_PHOTOS) count_photo++;
+        catalog_save();
+
         search_next_image();
     }
 }
 
+// DELTA Frame Handler, starts a tile patch
+// Format: <BBIIHIIB>
+// [0]=0x03, [1]=ver, [2..5]=file_id, [6..9]=total, [10..11]=chunk,
+// [12..15]=crc of the base image, [16..19]=crc once patched, [20]=flags
+// The DATA frames that follow carry TILE_REC-byte records. BAD answers a
+// base the card does not hold in a patchable layout, the sender then
+// falls back to the whole image.
+static void handle_delta(const uint8_t *buf, uint32_t frame_num) {
+    const uint32_t MIN_DELTA = 21u;
+    FRESULT res = FR_OK;
+    uint32_t src, base;
+    int up;
+
+    if (frame_num < MIN_DELTA) return;
+    if (rd16(buf + 10) == 0 || rd16(buf + 10) > MAX_CHUNK) {
+        send_ack(BAD);
+        uart_rx();
+        return;
+    }
+    memset(&transfer_info, 0, sizeof(transfer_info));
+    transfer_info.file_id = rd32(buf + 2);
+    transfer_info.total = rd32(buf + 6);
+    transfer_info.chunk = rd16(buf + 10);
+    fil = 0;
+    fb_fil = 0;
+    rle_fil = 0;
+    file_opened = 0;
+    rx_preview = 0;
+    rx_delta = 0;
+
+    uint32_t base_crc = rd32(buf + 12);
+    for (src = 0; src < count_photo; src++) {
+        if (base_crc && catalog[src].crc == base_crc) break;
+    }
+    uint32_t layout = (src < count_photo) ? image_rows(&catalog[src], &base, &up) : 0;
+    if (!layout || !transfer_info.total || transfer_info.total % TILE_REC) {
+        status_show("Patch base not on the card");
+        send_ack(BAD);
+        uart_rx();
+        return;
+    }
+
+    // Patch a copy in the next slot unless asked to patch in place, or the
+    // next slot is the base itself
+    uint32_t dst = (buf[20] & DELTA_INPLACE) ? src : photo_next;
+    catalog_entry_t *e = &catalog[src];
+    if (dst == src) {
+        snprintf(filename, sizeof(filename), "%s", layout == LAYOUT_FB ? e->fb_name : e->name);
+        delta_fil = file_get(filename, FA_READ | FA_WRITE, &res);
+        if (delta_fil) {
+            // Its other layouts go stale with the first tile
+            e->layouts = layout;
+            e->crc = 0;
+            e->base_crc = 0;
+            e->n_rects = 0;
+            image_drop(e);
+            catalog_save();
+        }
+    } else {
+        snprintf(filename, sizeof(filename), layout == LAYOUT_FB ? "image%lu.fb" : "image%lu.bmp", (unsigned long)dst);
+        delta_fil = delta_copy(layout == LAYOUT_FB ? e->fb_name : e->name, filename, &res);
+    }
+    if (!delta_fil) {
+        rx_abort(res);
+        send_ack(BAD);
+        uart_rx();
+        return;
+    }
+
+    rx_delta = 1;
+    rx_delta_src = src;
+    rx_delta_dst = dst;
+    rx_delta_layout = layout;
+    rx_delta_base = base;
+    rx_delta_up = up;
+    rx_delta_crc = rd32(buf + 16);
+    rx_delta_live = base_crc == vga_page_crc[vga_shown];
+    if (rx_delta_live) vga_page_crc[vga_shown] = 0;
+    rx_tile_pos = 0;
+    rx_percent = ~0u;
+    file_opened = 1;
+    transfer_info.active = 1;
+    send_ack(ACK);
+    uart_rx();
+}
+
+// Each slide is painted into the back page during the dwell of the one
+// before it, so a slide change is a page flip at the next frame. The
+// dwell runs on the machine timer and the CPU sleeps through it.
 static void search_next_image() {
+    int ready = rx_preview_take();  // back page holds slide photo_offset
+
     while (1) {
         uart_rx();
         if (photo_offset < count_photo) {
-            char next_filename[32];
-            snprintf(next_filename, sizeof(next_filename), "image%d.bmp", photo_offset);
-            display_rgb565_image(next_filename);
-        }
-        for (volatile int i = 0; i < 0xF00000; i++) {
-            uart_rx();
+            if (!ready) ready = display_slide(photo_offset);
+            if (ready) vga_flip();
         }
+        timer_stop(slide_timer);
+        slide_due = 0;
+        slide_timer = timer_start(TIMER_MS(SLIDE_MS), 0, slide_expired);
+
         photo_offset++;
-        if (photo_offset == count_photo) {
+        if (photo_offset >= count_photo) {
             photo_offset = 0;
         }
+        ready = 0;
+        if (photo_offset < count_photo) {
+#ifdef DISK_STATS
+            uint32_t reads = disk_reads;
+            uint64_t t0 = timer_now();
+            ready = display_slide(photo_offset);
+            printf("%s: %lu sector reads, %lu ms\n", catalog[photo_offset].name, (unsigned long)(disk_reads - reads),
+                   (unsigned long)((timer_now() - t0) / (MTIME_HZ / 1000)));
+#else
+            ready = display_slide(photo_offset);
+#endif
+        }
+        while (!slide_due) {
+            uart_rx();
+            if (uart_tail == uart_head) cpu_idle();
+        }
     }
 }
 
 int main(void) {
+    vga_show(0);
+    vga->wpage = vga_back;
+    // Clear both slide pages, the SRAM holds garbage after power-up
+    vga_blit_fill(0, 0, 0, IMG_WIDTH, IMG_HEIGHT, 0x0000);
+    vga_blit_fill(1, 0, 0, IMG_WIDTH, IMG_HEIGHT, 0x0000);
+    vga_blit_wait();
+    for (uint32_t y = 0; y < IMG_HEIGHT; y++) vga_line_offset(y, 0);
+    vga_gamma(GAMMA_Q);
+    vga_brightness(VGA_BRIGHT_MAX);
+    vga_text_clear();
+    vga->txt_ctrl = VGA_TXT_EN;
+    irq_init();
+    if (WAVE_FX) vga_on_vblank(vga_wave);
+    rgb565_init();
+    timer_start(UART_POLL_TICKS, UART_POLL_TICKS, uart_poll);
+
+    // Start the slideshow from the catalog, rebuild it only if it is unusable
+    if (!catalog_load(CATALOG_FILE) && !catalog_load(CATALOG_TMP)) {
+        catalog_rescan();
+    }
     search_next_image();
 }
\ No newline at end of file
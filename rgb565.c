@@ -0,0 +1,71 @@
+#include <stdint.h>
+#include "rgb565.h"
+
+// Bayer 4x4 thresholds, 0..15
+static const uint8_t bayer4[4][4] = {
+    {  0,  8,  2, 10 },
+    { 12,  4, 14,  6 },
+    {  3, 11,  1,  9 },
+    { 15,  7, 13,  5 },
+};
+
+// Saturating quantizers: value plus dither in, channel bits out, so the
+// inner loop has no compare or clamp
+static uint8_t q5[256 + 8];
+static uint8_t q6[256 + 4];
+
+void rgb565_init(void) {
+    for (uint32_t i = 0; i < sizeof(q5); i++) q5[i] = (i > 255 ? 255 : i) >> 3;
+    for (uint32_t i = 0; i < sizeof(q6); i++) q6[i] = (i > 255 ? 255 : i) >> 2;
+}
+
+// One pixel: the 5-bit channels step by 8, so they take the threshold / 2,
+// the 6-bit one steps by 4 and takes threshold / 4
+#define RGB565_PX(s, d) \
+    ((uint32_t)q5[(s)[2] + ((d) >> 1)] << 11 | (uint32_t)q6[(s)[1] + ((d) >> 2)] << 5 | q5[(s)[0] + ((d) >> 1)])
+
+// Inlined once per pixel size so step is a constant in the loops
+static inline void rgb565_convert(uint16_t *dst, const uint8_t *src, uint32_t n, uint32_t x, uint32_t y,
+                                  const uint32_t step) {
+    const uint8_t *d = bayer4[y & 3];
+
+    // Up to the next multiple of 4, where the threshold row starts over
+    while (n && (x & 3)) {
+        *dst++ = RGB565_PX(src, d[x & 3]);
+        src += step;
+        x++;
+        n--;
+    }
+
+    // Four pixels per pass, thresholds in registers, two word stores
+    const uint32_t d0 = d[0], d1 = d[1], d2 = d[2], d3 = d[3];
+    uint32_t *dst32 = (uint32_t *)dst;
+    for (; n >= 4; n -= 4) {
+        uint32_t p0 = RGB565_PX(src, d0);
+        uint32_t p1 = RGB565_PX(src + step, d1);
+        uint32_t p2 = RGB565_PX(src + 2 * step, d2);
+        uint32_t p3 = RGB565_PX(src + 3 * step, d3);
+        dst32[0] = p0 | (p1 << 16);
+        dst32[1] = p2 | (p3 << 16);
+        dst32 += 2;
+        src += 4 * step;
+    }
+
+    dst = (uint16_t *)dst32;
+    for (uint32_t i = 0; i < n; i++) {
+        *dst++ = RGB565_PX(src, d[i]);
+        src += step;
+    }
+}
+
+uint16_t rgb565_pixel(uint32_t r, uint32_t g, uint32_t b, uint32_t x, uint32_t y) {
+    const uint32_t d = bayer4[y & 3][x & 3];
+    const uint8_t s[3] = { (uint8_t)b, (uint8_t)g, (uint8_t)r };
+
+    return RGB565_PX(s, d);
+}
+
+void rgb565_row(uint16_t *dst, const uint8_t *src, uint32_t n, uint32_t x, uint32_t y, uint32_t bpp) {
+    if (bpp == 32) rgb565_convert(dst, src, n, x, y, 4);
+    else rgb565_convert(dst, src, n, x, y, 3);
+}
@@ -0,0 +1,21 @@
+#ifndef RGB565_H_
+#define RGB565_H_
+
+#include <stdint.h>
+
+// ======================================================================
+// RGB888 to RGB565 with a 4x4 ordered dither
+// The dither follows screen position, so rows converted piecewise still
+// line up with their neighbours.
+// ======================================================================
+void rgb565_init(void);
+
+// Converts n pixels of screen row y starting at column x. src holds
+// bpp / 8 bytes per pixel in BMP order (B, G, R, [A]), bpp 24 or 32.
+// dst points at column x of a row that is 4-byte aligned at column 0.
+void rgb565_row(uint16_t *dst, const uint8_t *src, uint32_t n, uint32_t x, uint32_t y, uint32_t bpp);
+
+// One pixel at column x of screen row y, channels 0..255
+uint16_t rgb565_pixel(uint32_t r, uint32_t g, uint32_t b, uint32_t x, uint32_t y);
+
+#endif /* RGB565_H_ */
@@ -0,0 +1,54 @@
+#include <stdint.h>
+#include <stdio.h>
+#include "FatFs/source/pal.h"
+#include "rgb565.h"
+
+// ======================================================================
+// RGB888 -> RGB565 dither timing
+// Build it in place of main.c by switching SRCS in the Makefile.
+// ======================================================================
+#define IMG_WIDTH   640
+#define IMG_HEIGHT  480
+#define BAUD_CYCLES 2604        // core cycles per UART bit, as in main.c
+#define BENCH_RUNS  2
+
+static uint8_t  src[IMG_WIDTH * 4];
+static uint16_t dst[IMG_WIDTH] __attribute__((aligned(4)));
+
+static inline uint32_t cycles(void) {
+    uint32_t c;
+    __asm__ volatile ("csrr %0, mcycle" : "=r"(c));
+    return c;
+}
+
+// One 640x480 frame, row by row as rx_transcode() hands them over
+static uint32_t bench_frame(uint32_t bpp) {
+    uint32_t t0 = cycles();
+    for (uint32_t y = 0; y < IMG_HEIGHT; y++) {
+        rgb565_row(dst, src, IMG_WIDTH, 0, y, bpp);
+    }
+    return cycles() - t0;
+}
+
+int main(void) {
+    for (uint32_t i = 0; i < sizeof(src); i++) src[i] = (uint8_t)(i * 37);
+    rgb565_init();
+
+    printf("=== RGB565 dither (%dx%d) ===\n", IMG_WIDTH, IMG_HEIGHT);
+    for (uint32_t bpp = 24; bpp <= 32; bpp += 8) {
+        // 10 UART bits per byte (8N1), so this many cycles go by while a frame arrives
+        uint32_t link = IMG_WIDTH * IMG_HEIGHT * (bpp / 8) * 10;
+        for (int run = 0; run < BENCH_RUNS; run++) {
+            uint32_t t = bench_frame(bpp);
+            printf("%lu bpp: %lu cycles/frame, %lu.%02lu cycles/pixel, %lu%% of the link time\n",
+                   (unsigned long)bpp, (unsigned long)t,
+                   (unsigned long)(t / (IMG_WIDTH * IMG_HEIGHT)),
+                   (unsigned long)(t % (IMG_WIDTH * IMG_HEIGHT) * 100 / (IMG_WIDTH * IMG_HEIGHT)),
+                   (unsigned long)((uint64_t)t * 100 / ((uint64_t)link * BAUD_CYCLES)));
+        }
+    }
+    printf("=== dither done ===\n");
+
+    while (1) { /* spin */ }
+    return 0;
+}
@@ -0,0 +1,143 @@
+#include <stdint.h>
+#include <string.h>
+#include "scale.h"
+#include "rgb565.h"
+
+// Per output column channel sums. A box is at most SCALE_MAX x SCALE_MAX
+// pixels of 255, so 16 bits hold it.
+static uint16_t acc_r[SCALE_W], acc_g[SCALE_W], acc_b[SCALE_W];
+static uint8_t  box_w[SCALE_W];     // source columns summed into each output column
+
+static uint16_t *(*sc_row_begin)(uint32_t y);
+static void     (*sc_row_end)(uint32_t y);
+static uint32_t sc_sw, sc_sh;       // source size
+static uint32_t sc_dw, sc_dh;       // scaled size
+static uint32_t sc_ox, sc_oy;       // top-left of the scaled image on screen
+static uint32_t sc_hdown, sc_vdown; // per axis, shrinking sums boxes, enlarging repeats
+static uint32_t sc_x, sc_j, sc_ex;  // source column, output column, its error term
+static uint32_t sc_r, sc_o, sc_ey;  // source row, output rows done (bottom-up), error term
+static uint32_t sc_rows;            // source rows summed for the next output row
+
+static void scale_size(uint32_t sw, uint32_t sh, uint32_t *dw, uint32_t *dh) {
+    if ((uint64_t)sw * SCALE_H <= (uint64_t)sh * SCALE_W) {
+        *dh = SCALE_H;
+        *dw = (uint32_t)((uint64_t)sw * SCALE_H / sh);
+    } else {
+        *dw = SCALE_W;
+        *dh = (uint32_t)((uint64_t)sh * SCALE_W / sw);
+    }
+}
+
+int scale_fits(uint32_t sw, uint32_t sh) {
+    uint32_t dw, dh;
+
+    if (!sw || !sh || sw > 0xFFFF || sh > 0xFFFF) return 0;
+    scale_size(sw, sh, &dw, &dh);
+    return dw && dh && sw <= SCALE_MAX * dw && sh <= SCALE_MAX * dh;
+}
+
+static void scale_black(uint32_t y) {
+    memset(sc_row_begin(y), 0, SCALE_W * 2);
+    sc_row_end(y);
+}
+
+// Averages the accumulators into output row y
+static void scale_emit(uint32_t y) {
+    uint16_t *dst = sc_row_begin(y);
+    uint32_t last = 0, rec = 0;
+
+    memset(dst, 0, sc_ox * 2);
+    for (uint32_t j = 0; j < sc_dw; j++) {
+        uint32_t n = box_w[j] * sc_rows;
+        if (n != last) {
+            last = n;
+            rec = (65536 + n / 2) / n;  // only changes between the two box widths
+        }
+        dst[sc_ox + j] = rgb565_pixel((acc_r[j] * rec + 32768) >> 16, (acc_g[j] * rec + 32768) >> 16,
+                                      (acc_b[j] * rec + 32768) >> 16, sc_ox + j, y);
+    }
+    memset(dst + sc_ox + sc_dw, 0, (SCALE_W - sc_ox - sc_dw) * 2);
+    sc_row_end(y);
+}
+
+static void scale_clear(void) {
+    memset(acc_r, 0, sizeof(acc_r));
+    memset(acc_g, 0, sizeof(acc_g));
+    memset(acc_b, 0, sizeof(acc_b));
+    sc_rows = 0;
+}
+
+void scale_begin(uint32_t sw, uint32_t sh, uint16_t *(*row_begin)(uint32_t y), void (*row_end)(uint32_t y)) {
+    sc_row_begin = row_begin;
+    sc_row_end = row_end;
+    sc_sw = sw;
+    sc_sh = sh;
+    scale_size(sw, sh, &sc_dw, &sc_dh);
+    sc_ox = (SCALE_W - sc_dw) / 2;
+    sc_oy = (SCALE_H - sc_dh) / 2;
+    sc_hdown = sc_dw <= sw;
+    sc_vdown = sc_dh <= sh;
+    sc_x = sc_j = sc_ex = 0;
+    sc_r = sc_o = sc_ey = 0;
+    scale_clear();
+    memset(box_w, sc_hdown ? 0 : 1, sizeof(box_w));
+
+    for (uint32_t y = SCALE_H - 1; y >= sc_oy + sc_dh; y--) scale_black(y);
+}
+
+void scale_pixel(uint32_t r, uint32_t g, uint32_t b) {
+    if (sc_hdown) {
+        // Column x adds to output column x * dw / sw
+        acc_r[sc_j] += r;
+        acc_g[sc_j] += g;
+        acc_b[sc_j] += b;
+        if (!sc_r) box_w[sc_j]++;
+        sc_ex += sc_dw;
+        if (sc_ex >= sc_sw) {
+            sc_ex -= sc_sw;
+            sc_j++;
+        }
+    } else {
+        // Output columns j with j * sw / dw == x take this pixel
+        while (sc_j < sc_dw) {
+            acc_r[sc_j] += r;
+            acc_g[sc_j] += g;
+            acc_b[sc_j] += b;
+            sc_j++;
+            sc_ex += sc_sw;
+            if (sc_ex >= sc_dw) {
+                sc_ex -= sc_dw;
+                break;
+            }
+        }
+    }
+    if (++sc_x < sc_sw) return;
+
+    // End of a source row: it completes output rows o with o * sh / dh == r
+    // when enlarging, or the one with r == (o + 1) * sh / dh - 1 when shrinking
+    sc_x = sc_j = sc_ex = 0;
+    sc_rows++;
+    if (sc_vdown) {
+        sc_ey += sc_dh;
+        if (sc_ey >= sc_sh) {
+            sc_ey -= sc_sh;
+            scale_emit(sc_oy + sc_dh - 1 - sc_o++);
+            scale_clear();
+        }
+    } else {
+        while (sc_o < sc_dh) {
+            scale_emit(sc_oy + sc_dh - 1 - sc_o++);
+            sc_ey += sc_sh;
+            if (sc_ey >= sc_dh) {
+                sc_ey -= sc_dh;
+                break;
+            }
+        }
+        scale_clear();
+    }
+    if (++sc_r < sc_sh) return;
+
+    // Whatever rounding left over, then the letterbox above
+    while (sc_o < sc_dh) scale_black(sc_oy + sc_dh - 1 - sc_o++);
+    for (uint32_t y = sc_oy; y-- > 0; ) scale_black(y);
+}
@@ -0,0 +1,25 @@
+#ifndef SCALE_H_
+#define SCALE_H_
+
+#include <stdint.h>
+
+// ======================================================================
+// Streaming resize of a bottom-up image to fit SCALE_W x SCALE_H
+// The aspect ratio is kept and the rest is letterboxed in black. Source
+// pixels go in one at a time in file order. Each output row is asked for
+// with row_begin(y) and handed back with row_end(y), bottom row first,
+// so only one row of accumulators is held. Shrinking averages boxes,
+// enlarging repeats pixels.
+// ======================================================================
+#define SCALE_W     640
+#define SCALE_H     480
+#define SCALE_MAX   16      // largest shrink factor per axis
+
+// 1 when a sw x sh image can be resized
+int  scale_fits(uint32_t sw, uint32_t sh);
+// Starts an image and emits the letterbox rows below it
+void scale_begin(uint32_t sw, uint32_t sh, uint16_t *(*row_begin)(uint32_t y), void (*row_end)(uint32_t y));
+// Next source pixel; the last one of the image also emits the rows above it
+void scale_pixel(uint32_t r, uint32_t g, uint32_t b);
+
+#endif /* SCALE_H_ */
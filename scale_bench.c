@@ -0,0 +1,68 @@
+#include <stdint.h>
+#include <stdio.h>
+#include "FatFs/source/pal.h"
+#include "rgb565.h"
+#include "scale.h"
+
+// ======================================================================
+// Streaming resize timing
+// Build it in place of main.c by switching SRCS in the Makefile.
+// ======================================================================
+#define BAUD_CYCLES 2604        // core cycles per UART bit, as in main.c
+#define BENCH_RUNS  2
+
+static uint16_t row[SCALE_W] __attribute__((aligned(4)));
+static uint32_t rows_out;
+
+static const struct { uint32_t w, h; } sizes[] = {
+    { 1920, 1080 },             // shrunk 3x, letterboxed top and bottom
+    { 320, 240 },               // enlarged 2x, fills the screen
+};
+
+static inline uint32_t cycles(void) {
+    uint32_t c;
+    __asm__ volatile ("csrr %0, mcycle" : "=r"(c));
+    return c;
+}
+
+static uint16_t *bench_row_begin(uint32_t y) {
+    (void)y;
+    return row;
+}
+
+static void bench_row_end(uint32_t y) {
+    (void)y;
+    rows_out++;
+}
+
+// One 24 bpp frame, pixel by pixel as rx_scale() hands them over
+static uint32_t bench_frame(uint32_t w, uint32_t h) {
+    uint32_t t0 = cycles();
+    scale_begin(w, h, bench_row_begin, bench_row_end);
+    for (uint32_t y = 0; y < h; y++) {
+        for (uint32_t x = 0; x < w; x++) scale_pixel(x & 0xFF, y & 0xFF, (x ^ y) & 0xFF);
+    }
+    return cycles() - t0;
+}
+
+int main(void) {
+    rgb565_init();
+
+    printf("=== resize to %dx%d ===\n", SCALE_W, SCALE_H);
+    for (uint32_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        uint32_t w = sizes[i].w, h = sizes[i].h;
+        // 10 UART bits per byte (8N1), so this many cycles go by while a frame arrives
+        uint64_t link = (uint64_t)w * h * 3 * 10 * BAUD_CYCLES;
+        for (int run = 0; run < BENCH_RUNS; run++) {
+            rows_out = 0;
+            uint32_t t = bench_frame(w, h);
+            printf("%lux%lu: %lu rows, %lu cycles/frame, %lu cycles/source pixel, %lu%% of the link time\n",
+                   (unsigned long)w, (unsigned long)h, (unsigned long)rows_out, (unsigned long)t,
+                   (unsigned long)(t / (w * h)), (unsigned long)((uint64_t)t * 100 / link));
+        }
+    }
+    printf("=== resize done ===\n");
+
+    while (1) { /* spin */ }
+    return 0;
+}
@@ -0,0 +1,58 @@
+#include <stdint.h>
+#include <stdio.h>
+#include "FatFs/source/pal.h"
+
+// ======================================================================
+// VGA frame fill timing
+// Build it in place of main.c by switching SRCS in the Makefile.
+// ======================================================================
+#define IMG_WIDTH   640
+#define IMG_HEIGHT  480
+#define FILL_RUNS   4
+
+static volatile uint32_t * const vga_fb = (volatile uint32_t *)0xD0000000;
+static volatile uint32_t * const vga_fb_packed = (volatile uint32_t *)0xD0200000;
+
+static CLINTRegBlk *const clint = (CLINTRegBlk *)CLINT_BASE;
+
+// Read the 64-bit machine timer without tearing between halves
+static uint64_t fill_ticks(void) {
+    uint32_t hi, lo;
+    do {
+        hi = clint->mtime.h;
+        lo = clint->mtime.l;
+    } while (hi != clint->mtime.h);
+    return ((uint64_t)hi << 32) | lo;
+}
+
+// One store per pixel
+static uint32_t fill_pixel(uint16_t color) {
+    uint64_t t0 = fill_ticks();
+    for (uint32_t i = 0; i < IMG_WIDTH * IMG_HEIGHT; i++) {
+        vga_fb[i] = color;
+    }
+    return (uint32_t)(fill_ticks() - t0);
+}
+
+// One store per pixel pair
+static uint32_t fill_packed(uint16_t color) {
+    uint32_t pair = ((uint32_t)color << 16) | color;
+    uint64_t t0 = fill_ticks();
+    for (uint32_t i = 0; i < IMG_WIDTH * IMG_HEIGHT / 2; i++) {
+        vga_fb_packed[i] = pair;
+    }
+    return (uint32_t)(fill_ticks() - t0);
+}
+
+int main(void) {
+    printf("=== VGA fill (%dx%d RGB565) ===\n", IMG_WIDTH, IMG_HEIGHT);
+    for (int run = 0; run < FILL_RUNS; run++) {
+        uint32_t pixel = fill_pixel(run & 1 ? 0xF800 : 0x001F);
+        uint32_t packed = fill_packed(run & 1 ? 0x07E0 : 0xFFFF);
+        printf("pixel: %lu ticks, packed: %lu ticks\n", (unsigned long)pixel, (unsigned long)packed);
+    }
+    printf("=== fill done ===\n");
+
+    while (1) { /* spin */ }
+    return 0;
+}